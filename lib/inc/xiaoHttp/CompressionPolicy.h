@@ -0,0 +1,55 @@
+/**
+ * @file CompressionPolicy.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-13
+ *
+ *
+ */
+
+#pragma once
+
+#include <xiaoHttp/exports.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace xiaoHttp
+{
+    /**
+     * @brief Decide which responses are compressed and how hard.
+     *
+     * The codings themselves are switched on with enableGzip(),
+     * enableBrotli() and enableZstd(). The policy is applied to the
+     * responses of those codings.
+     */
+    struct XIAOHTTP_EXPORT CompressionPolicy
+    {
+        /// Bodies shorter than this are sent as they are.
+        size_t minSize{1024};
+
+        /**
+         * @brief The MIME types that are compressed, like "application/json".
+         * An entry ending with '/' matches every subtype, like "text/".
+         *
+         * When it is empty, every type that is not binary is compressed.
+         */
+        std::vector<std::string> mimeTypes;
+
+        int gzipLevel{6};
+        int brotliLevel{5};
+        int zstdLevel{3};
+
+        /**
+         * @brief Load shedding, by the share of time the IO thread spent
+         * handling requests in the last second, from 0 to 1.
+         *
+         * Above reduceLevelBusyRatio the fastest level of each coding is
+         * used, above skipBusyRatio responses are not compressed at all.
+         * 0 disables the threshold.
+         */
+        double reduceLevelBusyRatio{0.0};
+        double skipBusyRatio{0.0};
+    };
+}
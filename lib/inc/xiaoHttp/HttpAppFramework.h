@@ -14,6 +14,8 @@
 #endif
 
 #include <xiaoHttp/exports.h>
+#include <xiaoHttp/CompressionPolicy.h>
+#include <xiaoHttp/JsonBackend.h>
 #include <xiaoHttp/utils/HttpConstraint.h>
 #include <xiaoHttp/HttpBinder.h>
 #include <xiaoHttp/HttpFilter.h>
@@ -725,6 +727,38 @@ namespace xiaoHttp
         /// Return true if brotli is enabled.
         virtual bool isBrotliEnabled() const = 0;
 
+        /// Enable zstd compression.
+        /**
+         * @param useZstd if the parameter is true, use zstd to compress the
+         * response body's content;
+         * The default value is false.
+         *
+         * @note
+         * This operation can be performed by an option in the configuration file.
+         * zstd is only available when xiaoHttp is built with libzstd. It is
+         * preferred over brotli and gzip when the client accepts it, under the
+         * same conditions as gzip.
+         */
+        virtual HttpAppFramework &enableZstd(bool useZstd) = 0;
+
+        /// Return true if zstd is enabled.
+        virtual bool isZstdEnabled() const = 0;
+
+        /// Set the policy that decides which responses are compressed.
+        /**
+         * @param policy The minimum size, the compressed MIME types, the
+         * level of each coding and the load thresholds above which the
+         * levels are lowered or compression is skipped.
+         *
+         * @note
+         * This operation can be performed by an option in the configuration file.
+         */
+        virtual HttpAppFramework &setCompressionPolicy(
+            const CompressionPolicy &policy) = 0;
+
+        /// Return the compression policy.
+        virtual const CompressionPolicy &compressionPolicy() const = 0;
+
         /// Set the time in which the static file response is cached in memory.
         /**
          * @param cacheTime in seconds. 0 means always cached, negative means no
@@ -738,6 +772,20 @@ namespace xiaoHttp
         /// Get the time set by the above method.
         virtual int staticFilesCacheTime() const = 0;
 
+        /// Set the number of parameterized routes cached per IO thread.
+        /**
+         * @param size The maximum number of (method, path) pairs whose routing
+         * result is remembered by each IO thread, the least recently used
+         * one is evicted first. 0 (the default) disables the cache.
+         *
+         * @note
+         * This operation can be performed by an option in the configuration file.
+         */
+        virtual HttpAppFramework &setRouteCacheSize(size_t size) = 0;
+
+        /// Get the size set by the above method.
+        virtual size_t routeCacheSize() const = 0;
+
         /// Set the lifetime of the connection without read or write
         /**
          * @param timeout in seconds. 60 by default. Setting the timeout to 0 means
@@ -837,6 +885,96 @@ namespace xiaoHttp
          */
         virtual HttpAppFramework &setBrStatic(bool useGzipStatic) = 0;
 
+        /// Set the cache of static file metadata.
+        /**
+         * Every IO thread keeps the stat() results of the static files it
+         * served, including whether the ".br" and ".gz" siblings exist, so
+         * a request for a known file needs no system call to locate it.
+         *
+         * @param maxEntries The number of files cached per IO thread, 0
+         * disables the cache. The default value is 1024.
+         * @param ttl The number of seconds a cached result is trusted, a
+         * file changed on disk is seen after at most this time. The default
+         * value is 5.
+         *
+         * @note
+         * This operation can be performed by an option in the configuration file.
+         */
+        virtual HttpAppFramework &setStaticFileInfoCache(size_t maxEntries,
+                                                         double ttl) = 0;
+
+        /// Watch the static files for changes.
+        /**
+         * @param watch If it is true, the document root and the roots of
+         * all locations are watched with inotify. A cached static file
+         * response, the cached metadata of the file and its compressed
+         * variants are dropped as soon as the file changes, so the static
+         * file cache time can be set to 0 (forever) without serving stale
+         * files. The default value is false. Only Linux is supported.
+         *
+         * @note
+         * This operation can be performed by an option in the configuration file.
+         */
+        virtual HttpAppFramework &enableStaticFilesWatching(bool watch) = 0;
+
+        /// Set the memory used to keep static files in memory.
+        /**
+         * @param maxBytes The memory shared by all IO threads for the cached
+         * static file responses, the least recently used ones are evicted
+         * when it is exceeded. 0 disables the cache. The default value is
+         * 64M.
+         * @param maxAssetSize Files up to this size are read into memory
+         * and sent from there, larger ones are sent from the disk and only
+         * their headers are cached. The default value is 256K.
+         *
+         * @note
+         * The time a response is cached is set by setStaticFilesCacheTime().
+         * This operation can be performed by an option in the configuration
+         * file.
+         */
+        virtual HttpAppFramework &setStaticAssetStore(size_t maxBytes,
+                                                      size_t maxAssetSize) = 0;
+
+        /// Compress static files in the background.
+        /**
+         * @param cacheDir The directory the compressed files are kept in. A
+         * file that the compression policy allows to compress is compressed
+         * with brotli and gzip at the best levels the first time it is
+         * requested, on a thread of its own. Until the job is done the file
+         * is sent as usual. The compressed files are named after the size
+         * and the modification time of the original one and are reused
+         * after a restart. Files with a precompressed sibling are not
+         * compressed. An empty string disables it, which is the default.
+         *
+         * @note
+         * The setGzipStatic() and setBrStatic() options apply to these
+         * files too. This operation can be performed by an option in the
+         * configuration file.
+         */
+        virtual HttpAppFramework &setStaticFilesPrecompression(
+            const std::string &cacheDir) = 0;
+
+        /// Set how the ETags of static files are made.
+        /**
+         * @param enable If it is false, static files have no ETag and only
+         * If-Modified-Since is used to revalidate them.
+         * @param useContentHash If it is false, the ETag is made of the
+         * inode, the size and the modification time of the file. If it is
+         * true, it is a SHA-256 of the content, so that servers with copies
+         * of the same files make the same ETags. It is computed in the
+         * background when a version of the file is first requested, the
+         * file_stat tag is sent until it is ready.
+         *
+         * If-None-Match, If-Match and If-Range are evaluated against the
+         * ETag. The default is enabled, without the content hash.
+         *
+         * @note
+         * This operation can be performed by an option in the configuration
+         * file.
+         */
+        virtual HttpAppFramework &setStaticFilesETag(bool enable,
+                                                     bool useContentHash) = 0;
+
         /// Set the max body size of the requests received by drogon.
         /**
          * The default value is 1M.
@@ -1035,6 +1173,20 @@ namespace xiaoHttp
          */
         virtual const std::pair<unsigned int, std::string> &
         getFloatPrecisionInJson() const noexcept = 0;
+
+        /**
+         * @brief Set the backend that parses the json bodies of requests and
+         * serializes the json objects of responses. The default one uses
+         * JsonCpp.
+         *
+         * @note
+         * This method must be called before running the application.
+         */
+        virtual HttpAppFramework &setJsonBackend(JsonBackendPtr backend) = 0;
+
+        /// Get the json backend.
+        virtual const JsonBackendPtr &getJsonBackend() const noexcept = 0;
+
         /// Create a database client
         /**
          * @param dbType The database type is one of
@@ -18,7 +18,12 @@
 #include <xiaoNet/net/Certificate.h>
 #include <xiaoNet/net/AsyncStream.h>
 #include <xiaoLog/Logger.h>
+#include <functional>
 #include <memory>
+#include <sstream>
+#ifdef __cpp_impl_coroutine
+#include <xiaoHttp/utils/coroutine.h>
+#endif
 
 #include <json/json.h>
 
@@ -68,11 +73,47 @@ namespace xiaoHttp
         return toResponse((const Json::Value &)pJson);
     }
 
+    class ResponseStream;
+
+    namespace internal
+    {
+        class ResponseStreamFlow;
+
+#ifdef __cpp_impl_coroutine
+        struct [[nodiscard]] ResponseStreamSendAwaiter
+            : public CallbackAwaiter<bool>
+        {
+        public:
+            ResponseStreamSendAwaiter(ResponseStream &stream,
+                                      std::string &&data)
+                : stream_(stream), data_(std::move(data))
+            {
+            }
+
+            // Sends the data, the coroutine is only suspended when the
+            // connection is congested.
+            bool await_ready();
+            void await_suspend(std::coroutine_handle<> handle);
+
+        private:
+            ResponseStream &stream_;
+            std::string data_;
+        };
+#endif
+    }
+
     class XIAOHTTP_EXPORT ResponseStream
     {
     public:
-        explicit ResponseStream(xiaoNet::AsyncStreamPtr asyncStream)
-            : asyncStream_(std::move(asyncStream))
+        /// Encode a piece of the stream into out, finish is true for the
+        /// call that ends the stream. Return false on failure.
+        using Encoder = std::function<
+            bool(const char *data, size_t len, bool finish, std::string &out)>;
+
+        explicit ResponseStream(
+            xiaoNet::AsyncStreamPtr asyncStream,
+            std::shared_ptr<internal::ResponseStreamFlow> flow = nullptr)
+            : asyncStream_(std::move(asyncStream)), flow_(std::move(flow))
         {
         }
 
@@ -81,31 +122,102 @@ namespace xiaoHttp
             close();
         }
 
+        /// The framework sets an encoder to compress the stream.
+        void setEncoder(Encoder encoder)
+        {
+            encoder_ = std::move(encoder);
+        }
+
         bool send(const std::string &data)
         {
             if (!asyncStream_)
             {
                 return false;
             }
-            std::ostringstream oss;
-            oss << std::hex << data.length() << "\r\n";
-            oss << data << "\r\n";
-            return asyncStream_->send(oss.str());
+            if (!encoder_)
+            {
+                return sendChunk(data);
+            }
+            std::string encoded;
+            if (!encoder_(data.data(), data.length(), false, encoded))
+            {
+                return false;
+            }
+            return sendChunk(encoded);
         }
 
         void close()
         {
             if (asyncStream_)
             {
+                if (encoder_)
+                {
+                    std::string encoded;
+                    if (encoder_(nullptr, 0, true, encoded))
+                        sendChunk(encoded);
+                    encoder_ = nullptr;
+                }
                 static std::string closeStream{"0\r\n\r\n"};
                 asyncStream_->send(closeStream);
                 asyncStream_->close();
                 asyncStream_.reset();
+                closeFlow();
             }
         }
 
+        /**
+         * @brief Be told when the client does not keep up with the stream.
+         *
+         * @p onHighWatermark is called when more than @p highWatermark bytes
+         * wait to be sent on the connection, @p onDrain when all of them
+         * have been sent after that. Both are called in the IO thread, a
+         * producer pauses on the first and goes on with the second.
+         */
+        void setWatermarkCallbacks(size_t highWatermark,
+                                   std::function<void()> onHighWatermark,
+                                   std::function<void()> onDrain);
+
+        /// Whether the data waiting on the connection went over the high
+        /// watermark and was not sent out yet.
+        bool isCongested() const;
+
+#ifdef __cpp_impl_coroutine
+        /**
+         * @brief Send data from a coroutine, the coroutine is resumed once
+         * the connection has drained if the data made it congested.
+         *
+         * co_await returns false when the stream is closed, like send().
+         */
+        internal::ResponseStreamSendAwaiter sendAsync(std::string data)
+        {
+            return internal::ResponseStreamSendAwaiter(*this,
+                                                       std::move(data));
+        }
+#endif
+
     private:
+#ifdef __cpp_impl_coroutine
+        friend struct internal::ResponseStreamSendAwaiter;
+#endif
+
+        void closeFlow();
+
+        bool sendChunk(const std::string &data)
+        {
+            // An empty chunk would end the stream
+            if (data.empty())
+            {
+                return true;
+            }
+            std::ostringstream oss;
+            oss << std::hex << data.length() << "\r\n";
+            oss << data << "\r\n";
+            return asyncStream_->send(oss.str());
+        }
+
         xiaoNet::AsyncStreamPtr asyncStream_;
+        Encoder encoder_;
+        std::shared_ptr<internal::ResponseStreamFlow> flow_;
     };
 
     using ResponseStreamPtr = std::unique_ptr<ResponseStream>;
@@ -345,6 +457,22 @@ namespace xiaoHttp
         /// Get the expiration time of the response.
         virtual ssize_t expiredTime() const = 0;
 
+        /// Render the response once and reuse the bytes for every send.
+        /**
+         * After this call the status line, the headers and the body are kept
+         * rendered, only the date is filled in when the response is sent. A
+         * frozen response can be returned from any IO thread at the same time
+         * without locking, which suits health checks, error pages and
+         * rejections that never change.
+         *
+         * @note
+         * The response must not be modified after it is frozen.
+         */
+        virtual void freeze() = 0;
+
+        /// Return true if the response is frozen.
+        virtual bool isFrozen() const = 0;
+
         ssize_t getExpiredTime() const
         {
             return expiredTime();
@@ -531,6 +659,9 @@ namespace xiaoHttp
          *                 still open. Once you have finished sending data, or the
          *                 stream->send() function returned false, you should call
          *                 stream->close() to gracefully close the chunked transfer.
+         *                 A producer faster than the client should watch
+         *                 stream->setWatermarkCallbacks() or use
+         *                 co_await stream->sendAsync() in a coroutine.
          * @param disableKickoffTimeout set this to true to disable trantors default
          *                              kickoff timeout. This is useful if you need
          *                              long running asynchronous streams.
@@ -0,0 +1,61 @@
+/**
+ * @file JsonBackend.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-24
+ *
+ *
+ */
+
+#pragma once
+
+#include <xiaoHttp/exports.h>
+#include <xiaoNet/utils/MsgBuffer.h>
+#include <json/json.h>
+#include <memory>
+#include <string>
+
+namespace xiaoHttp
+{
+    class JsonBackend;
+    using JsonBackendPtr = std::shared_ptr<JsonBackend>;
+
+    /**
+     * @brief Parse the json bodies of requests and responses, and serialize
+     * the json objects of responses.
+     *
+     * The methods are called from all IO threads at the same time, so a
+     * backend keeps its parser state per thread. The default backend uses
+     * JsonCpp, another one is set with app().setJsonBackend().
+     */
+    class XIAOHTTP_EXPORT JsonBackend
+    {
+    public:
+        virtual ~JsonBackend() = default;
+
+        /**
+         * @brief Parse the json text in [begin, end) into root.
+         *
+         * @return false if the text is not valid json, the reason is put in
+         * errs.
+         */
+        virtual bool parse(const char *begin,
+                           const char *end,
+                           Json::Value &root,
+                           std::string &errs) const = 0;
+
+        /// Append the json text of value to the buffer.
+        virtual void serialize(const Json::Value &value,
+                               xiaoNet::MsgBuffer &buffer) const = 0;
+
+        /**
+         * @brief The JsonCpp backend. It follows the stack limit, the
+         * unicode escaping and the float precision set on the app.
+         *
+         * Its readers and writers are created once per thread instead of
+         * once per message.
+         */
+        static JsonBackendPtr newJsonCppBackend();
+    };
+}
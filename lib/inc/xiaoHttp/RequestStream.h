@@ -1,5 +1,5 @@
 /**
- * @file Session.h
+ * @file RequestStream.h
  * @author Guo Xiao (746921314@qq.com)
  * @brief
  * @version 0.1
@@ -14,6 +14,8 @@
 #include <functional>
 #include <memory>
 #include <exception>
+#include <utility>
+#include <vector>
 
 namespace xiaoHttp
 {
@@ -30,11 +32,45 @@ namespace xiaoHttp
         std::string contentType;
     };
 
+    /// A file part of a multipart form, as it was written to disk.
+    struct MultipartFile
+    {
+        MultipartHeader header;
+        std::string path;
+        size_t size{0};
+        std::string md5;    // uppercase hex, empty if not computed
+        std::string sha256; // uppercase hex, empty if not computed
+    };
+
+    /// A multipart form read by RequestStreamReader::newMultipartFileReader()
+    struct MultipartForm
+    {
+        std::vector<std::pair<std::string, std::string>> fields;
+        std::vector<MultipartFile> files;
+    };
+
     class XIAOHTTP_EXPORT RequestStream
     {
     public:
         virtual ~RequestStream() = default;
-        virtual void setStreamReader(RequestStreamReader reader) = 0;
+        virtual void setStreamReader(RequestStreamReaderPtr reader) = 0;
+
+        /**
+         * @brief Set a reader that is given no more bytes than it was
+         * granted, for consumers slower than the network.
+         *
+         * When the credit is used up the connection stops reading from the
+         * socket, and it reads again once grantCredit() is called. At most
+         * one read of the socket is held back in memory meanwhile. The
+         * finish of the stream is delivered after the last byte, and the
+         * request is not over for the server before that, so a reader that
+         * stops granting credit holds the connection.
+         */
+        virtual void setStreamReader(RequestStreamReaderPtr reader,
+                                     size_t initialCredit) = 0;
+
+        /// Let the reader receive @p bytes more, from any thread.
+        virtual void grantCredit(size_t bytes) = 0;
     };
 
     using RequestStreamPtr = std::shared_ptr<RequestStream>;
@@ -103,9 +139,34 @@ namespace xiaoHttp
         using MultipartHeaderCallback = std::function<void(MultipartHeader header)>;
 
         static RequestStreamReaderPtr newMultipartReader(
-            cosnt HttpRequestPtr &req,
+            const HttpRequestPtr &req,
             MultipartHeaderCallback headerCb,
             StreamDataCallback dataCb,
             StreamFinishCallback finishCb);
+
+        /// Return the path a file part is written to, or an empty string to
+        /// discard the part.
+        using MultipartFilePathCallback =
+            std::function<std::string(const MultipartHeader &header)>;
+        using MultipartFormCallback =
+            std::function<void(MultipartForm form, std::exception_ptr)>;
+
+        /**
+         * @brief Read a multipart form, the file parts are written straight
+         * to disk as they arrive and the other fields are kept in memory.
+         *
+         * The body is never buffered as a whole, so large uploads take no
+         * more memory than the piece being read. When the stream fails or
+         * the form is malformed, the files already written are removed and
+         * @p formCb is called with the exception.
+         *
+         * @param computeDigests Compute the MD5 and SHA-256 of every file
+         * while it is written.
+         */
+        static RequestStreamReaderPtr newMultipartFileReader(
+            const HttpRequestPtr &req,
+            MultipartFilePathCallback pathCb,
+            MultipartFormCallback formCb,
+            bool computeDigests = true);
     };
 }
\ No newline at end of file
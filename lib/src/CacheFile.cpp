@@ -14,76 +14,159 @@
 #ifdef _WIN32
 
 #else
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
+#include <cerrno>
+#include <cstring>
 #endif
 
 using namespace xiaoHttp;
 
+// Appends are gathered up to this size before they are written
+static constexpr size_t kWriteBufferSize = 256 * 1024;
+
 CacheFile::CacheFile(const std::string &path, bool autoDelete)
     : autoDelete_(autoDelete), path_(path)
 {
-#ifndef _MSC_VER
-    file_ = fopen(path_.data(), "wb+");
+#ifndef _WIN32
+    fd_ = open(path_.data(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd_ < 0)
+        LOG_SYSERR << "open " << path_;
 #else
 #endif
 }
 
 CacheFile::~CacheFile()
 {
-    if (data_)
-    {
-        munmap(data_, dataLength_);
-    }
-    if (autoDelete_ && file_)
+    unmap();
+    if (fd_ < 0)
+        return;
+    close(fd_);
+    if (autoDelete_)
     {
-        fclose(file_);
 #if defined(_WIN32) && !defined(__MINGW32__)
 #else
         unlink(path_.data());
 #endif
     }
-    else if (file_)
+}
+
+void CacheFile::reserve(size_t length)
+{
+#ifdef __linux__
+    // The size of the file is kept, length() and the mapping are not
+    // affected by blocks allocated past the data.
+    if (fd_ >= 0 &&
+        fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(length)) <
+            0)
     {
-        fclose(file_);
+        LOG_TRACE << "fallocate: " << strerror(errno);
     }
+#else
+    (void)length;
+#endif
 }
 
 void CacheFile::append(const char *data, size_t length)
 {
-    if (file_)
-        fwrite(data, length, 1, file_);
+    if (fd_ < 0 || length == 0)
+        return;
+    // The body is read through the mapping once it is complete, an append
+    // after that maps the file again.
+    unmap();
+    if (bufferLength_ + length <= kWriteBufferSize)
+    {
+        if (!buffer_)
+            buffer_.reset(new char[kWriteBufferSize]);
+        memcpy(buffer_.get() + bufferLength_, data, length);
+        bufferLength_ += length;
+        return;
+    }
+    // A large piece is written along with the buffer in one call
+    flush(data, length);
 }
 
-size_t CacheFile::length()
+bool CacheFile::flush(const char *data, size_t length)
 {
-    if (file_)
-#ifdef _WIN32
-#else
-        return ftell(file_);
-#endif
-        return 0;
+    iovec iov[2];
+    iov[0].iov_base = buffer_.get();
+    iov[0].iov_len = bufferLength_;
+    iov[1].iov_base = const_cast<char *>(data);
+    iov[1].iov_len = length;
+    iovec *next = iov;
+    int count = 2;
+    while (count > 0)
+    {
+        if (next->iov_len == 0)
+        {
+            ++next;
+            --count;
+            continue;
+        }
+        auto n = pwritev(fd_, next, count, static_cast<off_t>(written_));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            LOG_SYSERR << "pwritev " << path_;
+            bufferLength_ = 0;
+            return false;
+        }
+        written_ += static_cast<size_t>(n);
+        // Skip what was written, a piece may be written partly
+        auto left = static_cast<size_t>(n);
+        while (left > 0 && left >= next->iov_len)
+        {
+            left -= next->iov_len;
+            next->iov_len = 0;
+            ++next;
+            --count;
+        }
+        if (left > 0)
+        {
+            next->iov_base = static_cast<char *>(next->iov_base) + left;
+            next->iov_len -= left;
+        }
+    }
+    bufferLength_ = 0;
+    return true;
+}
+
+void CacheFile::unmap()
+{
+    if (data_)
+    {
+        munmap(data_, dataLength_);
+        data_ = nullptr;
+        dataLength_ = 0;
+    }
 }
 
 char *CacheFile::data()
 {
-    if (!file_)
+    if (fd_ < 0)
         return nullptr;
     if (!data_)
     {
-        fflush(file_);
-#ifdef _WIN32
-#else
-        auto fd = fileno(file_);
-#endif
-        dataLength_ = length();
+        if (bufferLength_ > 0 && !flush())
+            return nullptr;
+        // An empty file can not be mapped
+        if (written_ == 0)
+            return nullptr;
+        dataLength_ = written_;
         data_ = static_cast<char *>(
-            mmap(nullptr, dataLength_, PROT_READ, MAP_SHARED, fd, 0));
+            mmap(nullptr, dataLength_, PROT_READ, MAP_SHARED, fd_, 0));
         if (data_ == MAP_FAILED)
         {
             data_ = nullptr;
+            dataLength_ = 0;
             LOG_SYSERR << "mmap: ";
+            return nullptr;
         }
+        // The body is usually parsed from the start to the end
+        madvise(data_, dataLength_, MADV_SEQUENTIAL);
     }
     return data_;
-}
\ No newline at end of file
+}
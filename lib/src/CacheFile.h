@@ -11,12 +11,20 @@
 #pragma once
 
 #include <xiaoNet/utils/NonCopyable.h>
+#include <memory>
 #include <string>
 #include <string_view>
-#include <stdio.h>
 
 namespace xiaoHttp
 {
+    /**
+     * @brief A temporary file that holds a request body too large for
+     * memory.
+     *
+     * The data is gathered in a buffer and written in large pieces, the
+     * whole body is then read through a read-only mapping of the file, so
+     * it is never copied back into memory.
+     */
     class CacheFile : public xiaoNet::NonCopyable
     {
     public:
@@ -31,6 +39,10 @@ namespace xiaoHttp
 
         void append(const char *data, size_t length);
 
+        /// Allocate the blocks of a body of the given length up front, so
+        /// the file is not extended piece by piece.
+        void reserve(size_t length);
+
         std::string_view getStringView()
         {
             if (data())
@@ -40,11 +52,21 @@ namespace xiaoHttp
 
     private:
         char *data();
-        size_t length();
-        FILE *file_{nullptr};
+        size_t length() const
+        {
+            return written_ + bufferLength_;
+        }
+        // Write the buffer and then the data, return false on error.
+        bool flush(const char *data = nullptr, size_t length = 0);
+        void unmap();
+
+        int fd_{-1};
         bool autoDelete_{true};
         const std::string path_;
+        std::unique_ptr<char[]> buffer_;
+        size_t bufferLength_{0};
+        size_t written_{0};
         char *data_{nullptr};
         size_t dataLength_{0};
     };
-}
\ No newline at end of file
+}
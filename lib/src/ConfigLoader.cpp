@@ -434,8 +434,33 @@ static void loadApp(const Json::Value &app)
     xiaoHttp::app().enableGzip(useGzip);
     auto useBr = app.get("use_brotli", false).asBool();
     xiaoHttp::app().enableBrotli(useBr);
+    auto useZstd = app.get("use_zstd", false).asBool();
+    xiaoHttp::app().enableZstd(useZstd);
+    auto &compression = app["compression"];
+    if (!compression.isNull())
+    {
+        CompressionPolicy policy;
+        policy.minSize = compression.get("min_size", 1024).asUInt64();
+        for (auto const &mimeType : compression["mime_types"])
+        {
+            policy.mimeTypes.push_back(mimeType.asString());
+        }
+        policy.gzipLevel =
+            compression.get("gzip_level", policy.gzipLevel).asInt();
+        policy.brotliLevel =
+            compression.get("brotli_level", policy.brotliLevel).asInt();
+        policy.zstdLevel =
+            compression.get("zstd_level", policy.zstdLevel).asInt();
+        policy.reduceLevelBusyRatio =
+            compression.get("reduce_level_busy_ratio", 0.0).asDouble();
+        policy.skipBusyRatio =
+            compression.get("skip_busy_ratio", 0.0).asDouble();
+        xiaoHttp::app().setCompressionPolicy(policy);
+    }
     auto staticFilesCacheTime = app.get("static_files_cache_time", 5).asInt();
     xiaoHttp::app().setStaticFilesCacheTime(staticFilesCacheTime);
+    auto routeCacheSize = app.get("route_cache_size", 0).asUInt64();
+    xiaoHttp::app().setRouteCacheSize(routeCacheSize);
     loadControllers(app["simple_controllers_map"]);
     // Kick off idle connections
     auto kickOffTimeout = app.get("idle_connection_timeout", 60).asUInt64();
@@ -455,6 +480,14 @@ static void loadApp(const Json::Value &app)
     xiaoHttp::app().setGzipStatic(useGzipStatic);
     auto useBrStatic = app.get("br_static", true).asBool();
     xiaoHttp::app().setBrStatic(useBrStatic);
+    auto fileInfoCacheSize =
+        app.get("static_file_info_cache_size", 1024).asUInt64();
+    auto fileInfoCacheTtl =
+        app.get("static_file_info_cache_ttl", 5.0).asDouble();
+    xiaoHttp::app().setStaticFileInfoCache(fileInfoCacheSize,
+                                           fileInfoCacheTtl);
+    auto watchStaticFiles = app.get("watch_static_files", false).asBool();
+    xiaoHttp::app().enableStaticFilesWatching(watchStaticFiles);
     auto maxBodySize = app.get("client_max_body_size", "1M").asString();
     size_t size;
     if (bytesSize(maxBodySize, size))
@@ -486,6 +519,30 @@ static void loadApp(const Json::Value &app)
         throw std::runtime_error(
             "Error format of client_max_websocket_message_size");
     }
+    auto assetStoreSize =
+        app.get("static_asset_store_size", "64M").asString();
+    size_t maxAssetSize;
+    if (!bytesSize(assetStoreSize, size))
+    {
+        throw std::runtime_error("Error format of static_asset_store_size");
+    }
+    auto maxAssetSizeStr = app.get("static_asset_max_size", "256K").asString();
+    if (!bytesSize(maxAssetSizeStr, maxAssetSize))
+    {
+        throw std::runtime_error("Error format of static_asset_max_size");
+    }
+    xiaoHttp::app().setStaticAssetStore(size, maxAssetSize);
+    xiaoHttp::app().setStaticFilesPrecompression(
+        app.get("static_files_precompression_dir", "").asString());
+    auto etag = app.get("static_files_etag", "file_stat").asString();
+    if (etag == "none")
+        xiaoHttp::app().setStaticFilesETag(false, false);
+    else if (etag == "file_stat")
+        xiaoHttp::app().setStaticFilesETag(true, false);
+    else if (etag == "content_hash")
+        xiaoHttp::app().setStaticFilesETag(true, true);
+    else
+        throw std::runtime_error("Error value of static_files_etag");
     xiaoHttp::app().enableReusePort(app.get("reuse_port", false).asBool());
     xiaoHttp::app().setHomePage(app.get("home_page", "index.html").asString());
     xiaoHttp::app().setImplicitPageEnable(
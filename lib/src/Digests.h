@@ -0,0 +1,75 @@
+/**
+ * @file Digests.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-18
+ *
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace xiaoHttp
+{
+    /**
+     * @brief MD5 computed over data that arrives in pieces.
+     *
+     * utils::getMd5() hashes a whole buffer with it, a stream is hashed by
+     * calling update() for every piece.
+     */
+    class Md5Digest
+    {
+    public:
+        static constexpr size_t kDigestLength = 16;
+
+        void update(const void *data, size_t length);
+
+        /// Finish the digest, the object must not be updated afterwards.
+        std::array<unsigned char, kDigestLength> finish();
+
+        /// Finish the digest and return it in uppercase hex.
+        std::string hexDigest();
+
+    private:
+        void transform(const unsigned char *block);
+
+        uint32_t state_[4]{0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+        uint64_t length_{0};
+        unsigned char buffer_[64];
+    };
+
+    /// SHA-256 computed over data that arrives in pieces.
+    class Sha256Digest
+    {
+    public:
+        static constexpr size_t kDigestLength = 32;
+
+        void update(const void *data, size_t length);
+
+        /// Finish the digest, the object must not be updated afterwards.
+        std::array<unsigned char, kDigestLength> finish();
+
+        /// Finish the digest and return it in uppercase hex.
+        std::string hexDigest();
+
+    private:
+        void transform(const unsigned char *block);
+
+        uint32_t state_[8]{0x6a09e667,
+                           0xbb67ae85,
+                           0x3c6ef372,
+                           0xa54ff53a,
+                           0x510e527f,
+                           0x9b05688c,
+                           0x1f83d9ab,
+                           0x5be0cd19};
+        uint64_t length_{0};
+        unsigned char buffer_[64];
+    };
+}
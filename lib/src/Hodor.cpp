@@ -78,6 +78,8 @@ void Hodor::initAndStart(const Json::Value &config)
     rejectResponse_->setBody(
         config.get("rejection_message", "Too many requests").asString());
     rejectResponse_->setCloseConnection(true);
+    // Shared by all IO threads, render it only once
+    rejectResponse_->freeze();
     limiterExpireTime_ =
         (std::max)(static_cast<size_t>(
                        config.get("limiter_expire_time", 600).asUInt()),
@@ -13,6 +13,7 @@
 
 #include "HttpResponseImpl.h"
 #include "StaticFileRouter.h"
+#include "HttpControllersRouter.h"
 
 #include <iostream>
 #include <memory>
@@ -157,6 +158,17 @@ int HttpAppFrameworkImpl::staticFilesCacheTime() const
     return StaticFileRouter::instance().staticFilesCacheTime();
 }
 
+HttpAppFramework &HttpAppFrameworkImpl::setRouteCacheSize(size_t size)
+{
+    HttpControllersRouter::instance().setRouteCacheSize(size);
+    return *this;
+}
+
+size_t HttpAppFrameworkImpl::routeCacheSize() const
+{
+    return HttpControllersRouter::instance().routeCacheSize();
+}
+
 HttpAppFramework &HttpAppFrameworkImpl::setGzipStatic(bool useGzipStatic)
 {
     StaticFileRouter::instance().setGzipStatic(useGzipStatic);
@@ -169,6 +181,45 @@ HttpAppFramework &HttpAppFrameworkImpl::setBrStatic(bool useGzipStatic)
     return *this;
 }
 
+HttpAppFramework &HttpAppFrameworkImpl::setStaticFileInfoCache(
+    size_t maxEntries,
+    double ttl)
+{
+    StaticFileRouter::instance().setFileInfoCache(maxEntries, ttl);
+    return *this;
+}
+
+HttpAppFramework &HttpAppFrameworkImpl::enableStaticFilesWatching(bool watch)
+{
+    StaticFileRouter::instance().setFileWatching(watch);
+    return *this;
+}
+
+HttpAppFramework &HttpAppFrameworkImpl::setStaticAssetStore(
+    size_t maxBytes,
+    size_t maxAssetSize)
+{
+    StaticFileRouter::instance().setAssetStore(maxBytes, maxAssetSize);
+    return *this;
+}
+
+HttpAppFramework &HttpAppFrameworkImpl::setStaticFilesPrecompression(
+    const std::string &cacheDir)
+{
+    StaticFileRouter::instance().setPrecompressionDir(cacheDir);
+    return *this;
+}
+
+HttpAppFramework &HttpAppFrameworkImpl::setStaticFilesETag(bool enable,
+                                                           bool useContentHash)
+{
+    using ETagMode = StaticFileRouter::ETagMode;
+    StaticFileRouter::instance().setETagMode(
+        !enable ? ETagMode::kNone
+                : useContentHash ? ETagMode::kContentHash : ETagMode::kFileStat);
+    return *this;
+}
+
 HttpAppFramework &HttpAppFrameworkImpl::setImplicitPageEnable(
     bool useImplicitPage)
 {
@@ -327,8 +327,33 @@ namespace xiaoHttp
             return useBrotli_;
         }
 
+        HttpAppFramework &enableZstd(bool useZstd) override
+        {
+            useZstd_ = useZstd;
+            return *this;
+        }
+
+        bool isZstdEnabled() const override
+        {
+            return useZstd_;
+        }
+
+        HttpAppFramework &setCompressionPolicy(
+            const CompressionPolicy &policy) override
+        {
+            compressionPolicy_ = policy;
+            return *this;
+        }
+
+        const CompressionPolicy &compressionPolicy() const override
+        {
+            return compressionPolicy_;
+        }
+
         HttpAppFramework &setStaticFilesCacheTime(int cacheTime) override;
         int staticFilesCacheTime() const override;
+        HttpAppFramework &setRouteCacheSize(size_t size) override;
+        size_t routeCacheSize() const override;
 
         HttpAppFramework &setIdleConnectionTimeout(size_t timeout) override
         {
@@ -355,6 +380,15 @@ namespace xiaoHttp
 
         HttpAppFramework &setGzipStatic(bool useGzipStatic) override;
         HttpAppFramework &setBrStatic(bool useGzipStatic) override;
+        HttpAppFramework &setStaticFileInfoCache(size_t maxEntries,
+                                                 double ttl) override;
+        HttpAppFramework &enableStaticFilesWatching(bool watch) override;
+        HttpAppFramework &setStaticAssetStore(size_t maxBytes,
+                                              size_t maxAssetSize) override;
+        HttpAppFramework &setStaticFilesPrecompression(
+            const std::string &cacheDir) override;
+        HttpAppFramework &setStaticFilesETag(bool enable,
+                                             bool useContentHash) override;
 
         HttpAppFramework &setClientMaxBodySize(size_t maxSize) override
         {
@@ -485,6 +519,19 @@ namespace xiaoHttp
             return floatPrecisionInJson_;
         }
 
+        HttpAppFramework &setJsonBackend(JsonBackendPtr backend) override
+        {
+            assert(!running_);
+            assert(backend);
+            jsonBackend_ = std::move(backend);
+            return *this;
+        }
+
+        const JsonBackendPtr &getJsonBackend() const noexcept override
+        {
+            return jsonBackend_;
+        }
+
         xiaoNet::EventLoop *getLoop() const override;
 
         xiaoNet::EventLoop *getIOLoop(size_t id) const override;
@@ -706,9 +753,12 @@ namespace xiaoHttp
         bool useSendfile_{true};
         bool useGzip_{true};
         bool useBrotli_{false};
+        bool useZstd_{false};
+        CompressionPolicy compressionPolicy_;
         bool usingUnicodeEscaping_{true};
         std::pair<unsigned int, std::string> floatPrecisionInJson_{0,
                                                                    "significant"};
+        JsonBackendPtr jsonBackend_{JsonBackend::newJsonCppBackend()};
         bool usingCustomErrorHandler_{false};
         size_t clientMaxBodySize_{1024 * 1024};
         size_t clientMaxMemoryBodySize_{64 * 1024};
@@ -0,0 +1,123 @@
+/**
+ * @file HttpCompressionPolicy.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-13
+ *
+ *
+ */
+
+#include "HttpCompressionPolicy.h"
+#include <algorithm>
+#include <cctype>
+
+using namespace xiaoHttp;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr auto kBusyWindow = std::chrono::seconds(1);
+
+    struct BusyMeter
+    {
+        Clock::time_point windowStart{Clock::now()};
+        Clock::duration busyTime{0};
+        double lastRatio{0.0};
+
+        // Close the window once it is a second old. A thread that was idle
+        // for longer gets a ratio over the whole idle period.
+        void roll(Clock::time_point now)
+        {
+            auto elapsed = now - windowStart;
+            if (elapsed < kBusyWindow)
+                return;
+            lastRatio = std::min(1.0,
+                                 std::chrono::duration<double>(busyTime) /
+                                     std::chrono::duration<double>(elapsed));
+            busyTime = Clock::duration{0};
+            windowStart = now;
+        }
+    };
+
+    thread_local BusyMeter busyMeter;
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b)
+    {
+        return a.length() == b.length() &&
+               std::equal(a.begin(),
+                          a.end(),
+                          b.begin(),
+                          [](unsigned char x, unsigned char y)
+                          { return tolower(x) == tolower(y); });
+    }
+}
+
+bool HttpCompressionPolicy::isCompressible(const CompressionPolicy &policy,
+                                           ContentType type,
+                                           std::string_view typeString,
+                                           size_t length)
+{
+    if (length != unknownLength && length < policy.minSize)
+        return false;
+    if (policy.mimeTypes.empty())
+        return type < CT_APPLICATION_OCTET_STREAM;
+
+    // Drop the parameters, "text/html; charset=utf-8" is "text/html"
+    auto semicolon = typeString.find(';');
+    if (semicolon != std::string_view::npos)
+        typeString = typeString.substr(0, semicolon);
+    while (!typeString.empty() && typeString.back() == ' ')
+        typeString.remove_suffix(1);
+    for (auto &mimeType : policy.mimeTypes)
+    {
+        if (!mimeType.empty() && mimeType.back() == '/')
+        {
+            if (equalsIgnoreCase(typeString.substr(0, mimeType.length()),
+                                 mimeType))
+                return true;
+        }
+        else if (equalsIgnoreCase(typeString, mimeType))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int HttpCompressionPolicy::level(const CompressionPolicy &policy,
+                                 ContentCoding coding)
+{
+    if (policy.skipBusyRatio > 0 || policy.reduceLevelBusyRatio > 0)
+    {
+        auto ratio = busyRatio();
+        if (policy.skipBusyRatio > 0 && ratio >= policy.skipBusyRatio)
+            return -1;
+        if (policy.reduceLevelBusyRatio > 0 &&
+            ratio >= policy.reduceLevelBusyRatio)
+            return HttpCompressor::fastestLevel(coding);
+    }
+    switch (coding)
+    {
+    case ContentCoding::kBrotli:
+        return policy.brotliLevel;
+    case ContentCoding::kZstd:
+        return policy.zstdLevel;
+    default:
+        return policy.gzipLevel;
+    }
+}
+
+void HttpCompressionPolicy::addBusyTime(Clock::duration busyTime,
+                                        Clock::time_point now)
+{
+    busyMeter.roll(now);
+    busyMeter.busyTime += busyTime;
+}
+
+double HttpCompressionPolicy::busyRatio(Clock::time_point now)
+{
+    busyMeter.roll(now);
+    return busyMeter.lastRatio;
+}
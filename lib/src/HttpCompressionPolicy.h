@@ -0,0 +1,58 @@
+/**
+ * @file HttpCompressionPolicy.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-13
+ *
+ *
+ */
+
+#pragma once
+
+#include "HttpCompressor.h"
+#include <xiaoHttp/CompressionPolicy.h>
+#include <xiaoHttp/HttpTypes.h>
+#include <chrono>
+#include <string_view>
+
+namespace xiaoHttp
+{
+    /**
+     * @brief Apply a CompressionPolicy to a response.
+     *
+     * The load of an IO thread is the share of time it spent in request
+     * handling, measured per second by the thread itself.
+     */
+    class HttpCompressionPolicy
+    {
+    public:
+        static constexpr size_t unknownLength = static_cast<size_t>(-1);
+
+        /**
+         * @brief Return true if the policy allows to compress a body of
+         * this type and length.
+         *
+         * @param length unknownLength for a stream.
+         */
+        static bool isCompressible(const CompressionPolicy &policy,
+                                   ContentType type,
+                                   std::string_view typeString,
+                                   size_t length);
+
+        /// The level to compress with on the current thread, -1 if the
+        /// thread is too busy to compress.
+        static int level(const CompressionPolicy &policy, ContentCoding coding);
+
+        /// Count time spent by the current thread on requests.
+        static void addBusyTime(
+            std::chrono::steady_clock::duration busyTime,
+            std::chrono::steady_clock::time_point now =
+                std::chrono::steady_clock::now());
+
+        /// The share of the last second the current thread was busy, @p now
+        /// closes that second if it is over.
+        static double busyRatio(std::chrono::steady_clock::time_point now =
+                                    std::chrono::steady_clock::now());
+    };
+}
@@ -0,0 +1,436 @@
+/**
+ * @file HttpCompressor.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-12
+ *
+ *
+ */
+
+#include "HttpCompressor.h"
+#include <xiaoLog/Logger.h>
+#include <zlib.h>
+#ifdef USE_BROTLI
+#include <brotli/encode.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+#include <algorithm>
+#include <vector>
+
+using namespace xiaoHttp;
+
+namespace
+{
+    // Output is produced in pieces of at least this size
+    constexpr size_t kOutputChunkSize = 16 * 1024;
+    // Compressors kept per coding and per thread
+    constexpr size_t kMaxIdleCompressors = 8;
+
+    class GzipCompressor : public StreamCompressor
+    {
+    public:
+        GzipCompressor()
+        {
+            ok_ = deflateInit2(&strm_,
+                               level_,
+                               Z_DEFLATED,
+                               MAX_WBITS + 16,
+                               8,
+                               Z_DEFAULT_STRATEGY) == Z_OK;
+            if (!ok_)
+                LOG_ERROR << "deflateInit2 error!";
+        }
+
+        ~GzipCompressor() override
+        {
+            if (ok_)
+                (void)deflateEnd(&strm_);
+        }
+
+        bool compress(const char *data,
+                      size_t len,
+                      Flush flush,
+                      std::string &out) override
+        {
+            if (!ok_)
+                return false;
+            // avail_in is 32 bits wide, feed larger inputs in slices
+            constexpr size_t maxSlice = 1 << 30;
+            do
+            {
+                auto slice = std::min(len, maxSlice);
+                auto last = slice == len;
+                int mode = Z_NO_FLUSH;
+                if (last && flush == Flush::kSync)
+                    mode = Z_SYNC_FLUSH;
+                else if (last && flush == Flush::kFinish)
+                    mode = Z_FINISH;
+                strm_.next_in =
+                    reinterpret_cast<Bytef *>(const_cast<char *>(data));
+                strm_.avail_in = static_cast<uInt>(slice);
+                auto chunk = std::max(slice / 2, kOutputChunkSize);
+                do
+                {
+                    auto oldSize = out.size();
+                    out.resize(oldSize + chunk);
+                    strm_.next_out =
+                        reinterpret_cast<Bytef *>(out.data() + oldSize);
+                    strm_.avail_out = static_cast<uInt>(chunk);
+                    if (deflate(&strm_, mode) == Z_STREAM_ERROR)
+                    {
+                        out.resize(oldSize);
+                        return false;
+                    }
+                    out.resize(oldSize + chunk - strm_.avail_out);
+                } while (strm_.avail_out == 0);
+                data += slice;
+                len -= slice;
+            } while (len > 0);
+            return true;
+        }
+
+        bool reset() override
+        {
+            return ok_ && deflateReset(&strm_) == Z_OK;
+        }
+
+        void setLevel(int level) override
+        {
+            level = std::clamp(level, Z_NO_COMPRESSION, Z_BEST_COMPRESSION);
+            if (!ok_ || level == level_)
+                return;
+            // Nothing was compressed since the reset, so nothing is flushed
+            if (deflateParams(&strm_, level, Z_DEFAULT_STRATEGY) == Z_OK)
+                level_ = level;
+        }
+
+        ContentCoding coding() const override
+        {
+            return ContentCoding::kGzip;
+        }
+
+    private:
+        z_stream strm_{};
+        int level_{6};
+        bool ok_{false};
+    };
+
+#ifdef USE_BROTLI
+    class BrotliCompressor : public StreamCompressor
+    {
+    public:
+        BrotliCompressor()
+        {
+            createState();
+        }
+
+        ~BrotliCompressor() override
+        {
+            if (state_)
+                BrotliEncoderDestroyInstance(state_);
+        }
+
+        bool compress(const char *data,
+                      size_t len,
+                      Flush flush,
+                      std::string &out) override
+        {
+            if (!state_)
+                return false;
+            auto op = BROTLI_OPERATION_PROCESS;
+            if (flush == Flush::kSync)
+                op = BROTLI_OPERATION_FLUSH;
+            else if (flush == Flush::kFinish)
+                op = BROTLI_OPERATION_FINISH;
+            auto nextIn = reinterpret_cast<const uint8_t *>(data);
+            size_t availIn = len;
+            while (true)
+            {
+                // The output is taken from the internal buffer of the
+                // encoder instead of being copied into a buffer of ours.
+                size_t availOut = 0;
+                if (!BrotliEncoderCompressStream(state_,
+                                                 op,
+                                                 &availIn,
+                                                 &nextIn,
+                                                 &availOut,
+                                                 nullptr,
+                                                 nullptr))
+                {
+                    return false;
+                }
+                size_t size = 0;
+                auto output = BrotliEncoderTakeOutput(state_, &size);
+                out.append(reinterpret_cast<const char *>(output), size);
+                if (availIn > 0 || BrotliEncoderHasMoreOutput(state_))
+                    continue;
+                if (op == BROTLI_OPERATION_FINISH &&
+                    !BrotliEncoderIsFinished(state_))
+                    continue;
+                return true;
+            }
+        }
+
+        bool reset() override
+        {
+            // The encoder has no reset function, the state is recreated.
+            if (state_)
+                BrotliEncoderDestroyInstance(state_);
+            createState();
+            return state_ != nullptr;
+        }
+
+        void setLevel(int level) override
+        {
+            quality_ = static_cast<uint32_t>(
+                std::clamp(level, BROTLI_MIN_QUALITY, BROTLI_MAX_QUALITY));
+            if (state_)
+                BrotliEncoderSetParameter(state_,
+                                          BROTLI_PARAM_QUALITY,
+                                          quality_);
+        }
+
+        ContentCoding coding() const override
+        {
+            return ContentCoding::kBrotli;
+        }
+
+    private:
+        void createState()
+        {
+            state_ = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+            if (!state_)
+            {
+                LOG_ERROR << "BrotliEncoderCreateInstance error!";
+                return;
+            }
+            BrotliEncoderSetParameter(state_, BROTLI_PARAM_QUALITY, quality_);
+        }
+
+        BrotliEncoderState *state_{nullptr};
+        uint32_t quality_{5};
+    };
+#endif
+
+#ifdef USE_ZSTD
+    class ZstdCompressor : public StreamCompressor
+    {
+    public:
+        ZstdCompressor() : cctx_(ZSTD_createCCtx())
+        {
+            if (!cctx_)
+            {
+                LOG_ERROR << "ZSTD_createCCtx error!";
+                return;
+            }
+            ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel, level_);
+        }
+
+        ~ZstdCompressor() override
+        {
+            ZSTD_freeCCtx(cctx_);
+        }
+
+        bool compress(const char *data,
+                      size_t len,
+                      Flush flush,
+                      std::string &out) override
+        {
+            if (!cctx_)
+                return false;
+            auto mode = ZSTD_e_continue;
+            if (flush == Flush::kSync)
+                mode = ZSTD_e_flush;
+            else if (flush == Flush::kFinish)
+                mode = ZSTD_e_end;
+            ZSTD_inBuffer input{data, len, 0};
+            auto chunk = std::max(len / 2, ZSTD_CStreamOutSize());
+            while (true)
+            {
+                auto oldSize = out.size();
+                out.resize(oldSize + chunk);
+                ZSTD_outBuffer output{out.data() + oldSize, chunk, 0};
+                auto remaining =
+                    ZSTD_compressStream2(cctx_, &output, &input, mode);
+                out.resize(oldSize + output.pos);
+                if (ZSTD_isError(remaining))
+                {
+                    LOG_ERROR << "zstd error: "
+                              << ZSTD_getErrorName(remaining);
+                    return false;
+                }
+                if (mode == ZSTD_e_continue ? input.pos == input.size
+                                            : remaining == 0)
+                    return true;
+            }
+        }
+
+        bool reset() override
+        {
+            // Keeps the parameters and the allocated tables
+            return cctx_ &&
+                   !ZSTD_isError(
+                       ZSTD_CCtx_reset(cctx_, ZSTD_reset_session_only));
+        }
+
+        void setLevel(int level) override
+        {
+            level = std::clamp(level, 1, ZSTD_maxCLevel());
+            if (!cctx_ || level == level_)
+                return;
+            // The parameters can be changed at the start of a stream
+            if (!ZSTD_isError(ZSTD_CCtx_setParameter(cctx_,
+                                                     ZSTD_c_compressionLevel,
+                                                     level)))
+                level_ = level;
+        }
+
+        ContentCoding coding() const override
+        {
+            return ContentCoding::kZstd;
+        }
+
+    private:
+        ZSTD_CCtx *cctx_;
+        int level_{3};
+    };
+#endif
+
+    struct CompressorPool
+    {
+        std::vector<std::unique_ptr<StreamCompressor>>
+            idle[static_cast<size_t>(ContentCoding::kCount)];
+
+        ~CompressorPool()
+        {
+            destroyed = true;
+        }
+
+        static CompressorPool &instance()
+        {
+            thread_local CompressorPool pool;
+            return pool;
+        }
+
+        // A compressor released while the thread is exiting must not go
+        // back to a pool that no longer exists.
+        static thread_local bool destroyed;
+    };
+
+    thread_local bool CompressorPool::destroyed = false;
+
+    std::unique_ptr<StreamCompressor> newCompressor(ContentCoding coding)
+    {
+        switch (coding)
+        {
+        case ContentCoding::kGzip:
+            return std::make_unique<GzipCompressor>();
+#ifdef USE_BROTLI
+        case ContentCoding::kBrotli:
+            return std::make_unique<BrotliCompressor>();
+#endif
+#ifdef USE_ZSTD
+        case ContentCoding::kZstd:
+            return std::make_unique<ZstdCompressor>();
+#endif
+        default:
+            return nullptr;
+        }
+    }
+}
+
+void StreamCompressorDeleter::operator()(StreamCompressor *compressor) const
+{
+    std::unique_ptr<StreamCompressor> ptr(compressor);
+    if (!ptr || CompressorPool::destroyed || !ptr->reset())
+        return;
+    auto &idle =
+        CompressorPool::instance().idle[static_cast<size_t>(ptr->coding())];
+    if (idle.size() < kMaxIdleCompressors)
+        idle.push_back(std::move(ptr));
+}
+
+StreamCompressorPtr HttpCompressor::acquire(ContentCoding coding, int level)
+{
+    if (!isSupported(coding))
+        return nullptr;
+    StreamCompressorPtr ptr;
+    if (!CompressorPool::destroyed)
+    {
+        auto &idle =
+            CompressorPool::instance().idle[static_cast<size_t>(coding)];
+        if (!idle.empty())
+        {
+            ptr.reset(idle.back().release());
+            idle.pop_back();
+        }
+    }
+    if (!ptr)
+        ptr.reset(newCompressor(coding).release());
+    ptr->setLevel(level);
+    return ptr;
+}
+
+std::string HttpCompressor::compress(ContentCoding coding,
+                                     int level,
+                                     const char *data,
+                                     size_t len)
+{
+    auto compressor = acquire(coding, level);
+    std::string out;
+    if (!compressor)
+        return out;
+    // Compressed text is usually well below half of the input
+    out.reserve(len / 2);
+    if (!compressor->compress(data, len, StreamCompressor::Flush::kFinish, out))
+        out.clear();
+    return out;
+}
+
+std::string_view HttpCompressor::name(ContentCoding coding)
+{
+    switch (coding)
+    {
+    case ContentCoding::kGzip:
+        return "gzip";
+    case ContentCoding::kBrotli:
+        return "br";
+    case ContentCoding::kZstd:
+        return "zstd";
+    default:
+        return {};
+    }
+}
+
+bool HttpCompressor::isSupported(ContentCoding coding)
+{
+    switch (coding)
+    {
+    case ContentCoding::kGzip:
+        return true;
+#ifdef USE_BROTLI
+    case ContentCoding::kBrotli:
+        return true;
+#endif
+#ifdef USE_ZSTD
+    case ContentCoding::kZstd:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+int HttpCompressor::fastestLevel(ContentCoding coding)
+{
+    switch (coding)
+    {
+    case ContentCoding::kBrotli:
+        return 0;
+    default:
+        return 1;
+    }
+}
@@ -0,0 +1,104 @@
+/**
+ * @file HttpCompressor.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-12
+ *
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace xiaoHttp
+{
+    enum class ContentCoding : uint8_t
+    {
+        kGzip,
+        kBrotli,
+        kZstd,
+        kCount
+    };
+
+    /**
+     * @brief An encoder state that compresses one stream at a time.
+     *
+     * The state is kept between streams, reset() only starts a new one, so
+     * the internal buffers of the codec are allocated once per compressor.
+     */
+    class StreamCompressor
+    {
+    public:
+        enum class Flush
+        {
+            kNone,  // the codec may hold the input back
+            kSync,  // emit everything compressed so far
+            kFinish // end the stream
+        };
+
+        virtual ~StreamCompressor() = default;
+
+        /**
+         * @brief Compress a piece of the stream and append the output to
+         * @p out.
+         *
+         * @return false if the codec failed, the stream can not be continued
+         * in this case.
+         */
+        virtual bool compress(const char *data,
+                              size_t len,
+                              Flush flush,
+                              std::string &out) = 0;
+
+        /// Start a new stream, return false if the state can not be reused.
+        virtual bool reset() = 0;
+
+        /// Set the level of the next stream, before any data is compressed.
+        virtual void setLevel(int level) = 0;
+
+        virtual ContentCoding coding() const = 0;
+    };
+
+    struct StreamCompressorDeleter
+    {
+        // Give the compressor back to the pool of the current thread.
+        void operator()(StreamCompressor *compressor) const;
+    };
+
+    using StreamCompressorPtr =
+        std::unique_ptr<StreamCompressor, StreamCompressorDeleter>;
+
+    /**
+     * @brief The compressors used for response bodies.
+     *
+     * Compressors are pooled per thread, a response takes one from the pool
+     * of its IO thread and returns it when it is done, so the codec state is
+     * reset instead of being created for every response.
+     */
+    class HttpCompressor
+    {
+    public:
+        /// Return nullptr if the coding is not supported by this build.
+        static StreamCompressorPtr acquire(ContentCoding coding, int level);
+
+        /// Compress a whole buffer, return an empty string on failure.
+        static std::string compress(ContentCoding coding,
+                                    int level,
+                                    const char *data,
+                                    size_t len);
+
+        /// The level that compresses fastest.
+        static int fastestLevel(ContentCoding coding);
+
+        /// The value of the content-encoding header for the coding.
+        static std::string_view name(ContentCoding coding);
+
+        static bool isSupported(ContentCoding coding);
+    };
+}
@@ -62,10 +62,23 @@ void HttpControllersRouter::init(
         initFiltersAndCorsMethods(iter.second);
     }
 
-    for (auto &iter : ctrlVector_)
+    ++routesVersion_;
+    if (routeCacheSize_ > 0)
     {
-        router.regex_ = std::regex(router.pathParameterPattern_,
-                                   std::regex_constants::icase);
+        routeCache_ = std::make_unique<IOThreadStorage<RouteCache>>(
+            routeCacheSize_);
+    }
+    ctrlTrie_.clear();
+    regexCtrlIndices_.clear();
+    for (size_t i = 0; i < ctrlVector_.size(); ++i)
+    {
+        auto &router = ctrlVector_[i];
+        if (!ctrlTrie_.insert(router.pathParameterPattern_, i))
+        {
+            router.regex_ = std::regex(router.pathParameterPattern_,
+                                       std::regex_constants::icase);
+            regexCtrlIndices_.push_back(i);
+        }
         initFiltersAndCorsMethods(router);
     }
 
@@ -83,6 +96,10 @@ void HttpControllersRouter::reset()
     simpleCtrlMap_.clear();
     ctrlMap_.clear();
     ctrlVector_.clear();
+    ctrlTrie_.clear();
+    regexCtrlIndices_.clear();
+    routeCache_.reset();
+    ++routesVersion_;
     wsCtrlMap_.clear();
 }
 
@@ -143,6 +160,50 @@ std::vector<HttpHandlerInfo> HttpControllersRouter::getHandlersInfo() const
     return ret;
 }
 
+// Convert a path like /api/{id}/files/{path...} to the regex that matches
+// it. A placeholder matches one path segment, a trailing {name...} matches
+// the rest of the path and '.' is taken literally.
+static std::string pathTemplateToRegex(const std::string &path)
+{
+    std::string pattern;
+    size_t pos = 0;
+    while (pos < path.length())
+    {
+        auto c = path[pos];
+        if (c == '{')
+        {
+            // Same extent as \{([^/]*)\}: up to the last '}' of the segment
+            auto segEnd = path.find('/', pos);
+            if (segEnd == std::string::npos)
+                segEnd = path.length();
+            auto close = path.rfind('}', segEnd - 1);
+            if (close != std::string::npos && close > pos)
+            {
+                std::string_view name(path.data() + pos + 1, close - pos - 1);
+                if (close + 1 == path.length() && name.ends_with("..."))
+                {
+                    pattern.append("(.*)");
+                }
+                else
+                {
+                    pattern.append("([^/]*)");
+                }
+                pos = close + 1;
+                continue;
+            }
+        }
+        else if (c == '.')
+        {
+            pattern.append("\\.");
+            ++pos;
+            continue;
+        }
+        pattern.push_back(c);
+        ++pos;
+    }
+    return pattern;
+}
+
 template <typename Binder, typename RouterItem>
 static void addCtrlBinderToRouterItem(const std::shared_ptr<Binder> &binderPtr,
                                       RouterItem &router,
@@ -552,9 +613,10 @@ void HttpControllersRouter::addHttpPath(
         binderInfo->responseCache_ = IOThreadStorage<HttpResponsePtr>(); });
 
     // Create or update RouterItem
-    auto pathParameterPattern =
-        std::regex_replace(originPath, regex, "([^/]*)");
-    if (originPath != pathParameterPattern) // require regex
+    auto pathParameterPattern = pathTemplateToRegex(originPath);
+    // Query placeholders also count in placeIndex, only the path ones
+    // need the trie
+    if (!binderInfo->parameterPlaces_.empty()) // has path parameters
     {
         addRegexCtrlBinder(binderInfo,
                            path,
@@ -588,6 +650,28 @@ void HttpControllersRouter::addHttpPath(
     }
 
     addCtrlBinderToRouterItem(binderInfo, *routerItemPtr, validMethods);
+    ++routesVersion_;
+}
+
+HttpRouteTrie::Captures HttpControllersRouter::placeParameters(
+    const HttpControllerBinder &binder,
+    const HttpRouteTrie::Captures &captures)
+{
+    HttpRouteTrie::Captures placed;
+    for (size_t j = 1; j <= captures.size(); ++j)
+    {
+        if (captures[j - 1].first == HttpRouteTrie::npos)
+            continue;
+        size_t place = j;
+        if (j <= binder.parameterPlaces_.size())
+        {
+            place = binder.parameterPlaces_[j - 1];
+        }
+        if (place > placed.size())
+            placed.resize(place, {HttpRouteTrie::npos, 0});
+        placed[place - 1] = captures[j - 1];
+    }
+    return placed;
 }
 
 RouteResult HttpControllersRouter::route(const HttpRequestImplPtr &req)
@@ -615,24 +699,78 @@ RouteResult HttpControllersRouter::route(const HttpRequestImplPtr &req)
 
     // Find http controller
     HttpControllerRouterItem *routerItemPtr = nullptr;
-    std::smatch result;
+    const auto method = req->method();
+    const auto &path = req->path();
+    // (offset, length) in the path of each routing parameter, in the order
+    // of the handler arguments. The offset is npos for an empty parameter.
+    HttpRouteTrie::Captures paramOffsets;
+    RouteCache *routeCache = nullptr;
+    static thread_local std::string cacheKey;
     auto it = ctrlMap_.find(loweredPath);
-    // Try to find a controller in the hash map. If can't linear search
-    // with regex.
+    // Try to find a controller in the hash map. If can't, search the route
+    // cache, then the trie and the routes that need a regex. The first
+    // registered route wins.
     if (it != ctrlMap_.end())
     {
         routerItemPtr = &it->second;
     }
     else
     {
-        for (auto &item : ctrlVector_)
+        if (routeCache_)
         {
-            const auto &ctrlRegex = item.regex_;
-            if (item.binders_[req->method()] &&
-                std::regex_match(req->path(), result, ctrlRegex))
+            routeCache = &routeCache_->getThreadData();
+            cacheKey.assign(1, static_cast<char>(method));
+            cacheKey.append(loweredPath);
+            auto cached = routeCache->find(cacheKey);
+            if (cached && cached->version == routesVersion_)
             {
-                routerItemPtr = &item;
-                break;
+                routerItemPtr = cached->item;
+                paramOffsets = cached->paramOffsets;
+            }
+        }
+        if (!routerItemPtr)
+        {
+            HttpRouteTrie::Captures captures;
+            auto index = ctrlTrie_.match(
+                loweredPath,
+                [this, method](size_t i)
+                { return ctrlVector_[i].binders_[method] != nullptr; },
+                captures);
+            std::smatch result;
+            for (auto i : regexCtrlIndices_)
+            {
+                if (i >= index)
+                    break;
+                auto &item = ctrlVector_[i];
+                if (item.binders_[method] &&
+                    std::regex_match(path, result, item.regex_))
+                {
+                    index = i;
+                    captures.clear();
+                    for (size_t j = 1; j < result.size(); ++j)
+                    {
+                        captures.emplace_back(
+                            result[j].matched
+                                ? static_cast<size_t>(result[j].first -
+                                                      path.begin())
+                                : HttpRouteTrie::npos,
+                            result[j].length());
+                    }
+                    break;
+                }
+            }
+            if (index != HttpRouteTrie::npos)
+            {
+                routerItemPtr = &ctrlVector_[index];
+                paramOffsets = placeParameters(*routerItemPtr->binders_[method],
+                                               captures);
+                if (routeCache)
+                {
+                    routeCache->insert(cacheKey,
+                                       {routerItemPtr,
+                                        paramOffsets,
+                                        routesVersion_});
+                }
             }
         }
     }
@@ -643,27 +781,21 @@ RouteResult HttpControllersRouter::route(const HttpRequestImplPtr &req)
         return {RouteResult::NotFound, nullptr};
     }
     HttpControllerRouterItem &routerItem = *routerItemPtr;
-    assert(Invalid > req->method());
+    assert(Invalid > method);
     req->setMatchedPathPattern(routerItem.pathPattern_);
-    auto &binder = routerItem.binders_[req->method()];
+    auto &binder = routerItem.binders_[method];
     if (!binder)
     {
         return {RouteResult::MethodNotAllowed, nullptr};
     }
-    std::vector<std::string> params;
-    for (size_t j = 1; j < result.size(); ++j)
+    std::vector<std::string> params(paramOffsets.size());
+    for (size_t i = 0; i < paramOffsets.size(); ++i)
     {
-        if (!result[j].matched)
+        auto &[offset, length] = paramOffsets[i];
+        if (offset == HttpRouteTrie::npos)
             continue;
-        size_t place = j;
-        if (j <= binder->parameterPlaces_.size())
-        {
-            place = binder->parameterPlaces_[j - 1];
-        }
-        if (place > params.size())
-            params.resize(place);
-        params[place - 1] = result[j].str();
-        LOG_TRACE << "place=" << place << " para:" << params[place - 1];
+        params[i] = path.substr(offset, length);
+        LOG_TRACE << "place=" << i + 1 << " para:" << params[i];
     }
     if (!binder->queryParametersPlaces_.empty())
     {
@@ -761,4 +893,5 @@ void HttpControllersRouter::addRegexCtrlBinder(
     }
 
     addCtrlBinderToRouterItem(binderPtr, *routerItemPtr, methods);
+    ++routesVersion_;
 }
\ No newline at end of file
@@ -12,7 +12,11 @@
 
 #include "impl_forwards.h"
 #include "ControllerBinderBase.h"
+#include "HttpRouteTrie.h"
+#include "LruCache.h"
+#include <xiaoHttp/IOThreadStorage.h>
 #include <xiaoNet/utils/NonCopyable.h>
+#include <atomic>
 #include <memory>
 #include <regex>
 #include <unordered_map>
@@ -56,6 +60,21 @@ namespace xiaoHttp
                           const std::vector<std::string> &filters,
                           const std::string &handlerName = "");
         RouteResult route(const HttpRequestImplPtr &req);
+
+        /**
+         * @brief Set the number of parameterized routes cached per IO loop,
+         * 0 disables the cache. Takes effect in init().
+         */
+        void setRouteCacheSize(size_t size)
+        {
+            routeCacheSize_ = size;
+        }
+
+        size_t routeCacheSize() const
+        {
+            return routeCacheSize_;
+        }
+
         RouteResult routeWs(const HttpRequestImplPtr &req);
         std::vector<HttpHandlerInfo> getHandlersInfo() const;
 
@@ -87,6 +106,28 @@ namespace xiaoHttp
         std::unordered_map<std::string, SimpleControllerRouterItem> simpleCtrlMap_;
         std::unordered_map<std::string, HttpControllerRouterItem> ctrlMap_;
         std::vector<HttpControllerRouterItem> ctrlVector_; // for regexp path
+        // Items of ctrlVector_ that are matched segment by segment
+        HttpRouteTrie ctrlTrie_;
+        // Indices of the items of ctrlVector_ that need std::regex
+        std::vector<size_t> regexCtrlIndices_;
+
+        struct CachedRoute
+        {
+            HttpControllerRouterItem *item;
+            HttpRouteTrie::Captures paramOffsets;
+            uint64_t version;
+        };
+        // Keyed on the method byte followed by the lowered path
+        using RouteCache = LruCache<CachedRoute>;
+
+        static HttpRouteTrie::Captures placeParameters(
+            const HttpControllerBinder &binder,
+            const HttpRouteTrie::Captures &captures);
+
+        std::unique_ptr<IOThreadStorage<RouteCache>> routeCache_;
+        size_t routeCacheSize_{0};
+        // Bumped when routes change, older cache entries are ignored.
+        std::atomic<uint64_t> routesVersion_{0};
         std::unordered_map<std::string, WebSocketControllerRouterItem> wsCtrlMap_;
     };
 }
\ No newline at end of file
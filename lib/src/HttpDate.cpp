@@ -0,0 +1,67 @@
+/**
+ * @file HttpDate.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-11
+ *
+ *
+ */
+
+#include "HttpDate.h"
+#include <xiaoHttp/utils/Utilities.h>
+#include <xiaoNet/net/EventLoop.h>
+#include <xiaoLog/Date.h>
+
+using namespace xiaoHttp;
+
+namespace
+{
+    struct DateSlot
+    {
+        char date[32]{0};
+        bool timerInstalled{false};
+    };
+
+    thread_local DateSlot dateSlot;
+
+    void refreshDateSlot()
+    {
+        xiaoLog::Date::now().toCustomFormattedString(
+            "%a, %d %b %Y %H:%M:%S GMT", dateSlot.date, sizeof(dateSlot.date));
+    }
+
+    // Refresh the slot at the next second boundary. The timer is armed
+    // again from the current time after every refresh, a periodic timer
+    // would drift away from the boundary by its latency on each tick.
+    void scheduleDateRefresh(xiaoNet::EventLoop *loop)
+    {
+        auto now = xiaoLog::Date::now().microSecondsSinceEpoch();
+        auto toNextSecond =
+            static_cast<double>(MICRO_SECONDS_PRE_SEC -
+                                now % MICRO_SECONDS_PRE_SEC) /
+            MICRO_SECONDS_PRE_SEC;
+        loop->runAfter(toNextSecond,
+                       [loop]()
+                       {
+                           refreshDateSlot();
+                           scheduleDateRefresh(loop);
+                       });
+    }
+}
+
+std::string_view xiaoHttp::currentHttpDate()
+{
+    if (!dateSlot.timerInstalled)
+    {
+        auto *loop = xiaoNet::EventLoop::getEventLoopOfCurrentThread();
+        if (!loop)
+        {
+            return {utils::getHttpFullDate(), httpFullDateStringLength};
+        }
+        dateSlot.timerInstalled = true;
+        refreshDateSlot();
+        scheduleDateRefresh(loop);
+    }
+    return {dateSlot.date, httpFullDateStringLength};
+}
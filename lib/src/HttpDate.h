@@ -0,0 +1,30 @@
+/**
+ * @file HttpDate.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-11
+ *
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace xiaoHttp
+{
+    // "Fri, 23 Aug 2019 12:58:03 GMT" length = 29
+    constexpr size_t httpFullDateStringLength = 29;
+
+    /**
+     * @brief Return the value of the Date header for the current second.
+     *
+     * Each IO loop keeps the formatted date in a thread local slot that a
+     * timer refreshes on every second boundary, the first call on a loop
+     * installs the timer. Threads without an event loop format the date on
+     * demand. The view is valid until the next call on the same thread.
+     */
+    std::string_view currentHttpDate();
+}
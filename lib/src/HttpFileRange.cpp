@@ -0,0 +1,112 @@
+/**
+ * @file HttpFileRange.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-22
+ *
+ *
+ */
+
+#include "HttpFileRange.h"
+#include <algorithm>
+#include <charconv>
+
+namespace xiaoHttp
+{
+    static bool parseRangeNumber(std::string_view str, size_t &value)
+    {
+        if (str.empty())
+            return false;
+        auto [ptr, ec] =
+            std::from_chars(str.data(), str.data() + str.size(), value);
+        return ec == std::errc() && ptr == str.data() + str.size();
+    }
+
+    FileRangeParseResult parseRangeHeader(std::string_view range,
+                                          size_t contentLength,
+                                          std::vector<FileRange> &ranges)
+    {
+        ranges.clear();
+        constexpr std::string_view unit = "bytes=";
+        if (range.substr(0, unit.size()) != unit)
+            return FileRangeParseResult::InvalidRange;
+        range.remove_prefix(unit.size());
+        // Bounds the work spent on a header of many tiny or overlapping
+        // ranges, they would only be merged and rejected after the sort
+        size_t specCount = 0;
+        while (!range.empty())
+        {
+            if (++specCount > 2 * kMaxFileRanges)
+            {
+                ranges.clear();
+                return FileRangeParseResult::InvalidRange;
+            }
+            auto comma = range.find(',');
+            auto spec = range.substr(0, comma);
+            range = comma == std::string_view::npos ? std::string_view{}
+                                                    : range.substr(comma + 1);
+            auto notSpace = spec.find_first_not_of(" \t");
+            if (notSpace == std::string_view::npos)
+                continue;
+            spec = spec.substr(notSpace,
+                               spec.find_last_not_of(" \t") + 1 - notSpace);
+            auto dash = spec.find('-');
+            if (dash == std::string_view::npos)
+                return FileRangeParseResult::InvalidRange;
+            auto first = spec.substr(0, dash);
+            auto last = spec.substr(dash + 1);
+            size_t start, end;
+            if (first.empty())
+            {
+                // The suffix of the given length
+                size_t length;
+                if (!parseRangeNumber(last, length))
+                    return FileRangeParseResult::InvalidRange;
+                if (length == 0 || contentLength == 0)
+                    continue;
+                start = contentLength > length ? contentLength - length : 0;
+                end = contentLength;
+            }
+            else
+            {
+                if (!parseRangeNumber(first, start))
+                    return FileRangeParseResult::InvalidRange;
+                end = contentLength;
+                if (!last.empty())
+                {
+                    size_t lastPos;
+                    if (!parseRangeNumber(last, lastPos) || lastPos < start)
+                        return FileRangeParseResult::InvalidRange;
+                    end = lastPos >= contentLength ? contentLength : lastPos + 1;
+                }
+                if (start >= contentLength)
+                    continue;
+            }
+            ranges.push_back({start, end});
+        }
+        if (ranges.empty())
+            return FileRangeParseResult::NotSatisfiable;
+        std::sort(ranges.begin(),
+                  ranges.end(),
+                  [](const FileRange &a, const FileRange &b)
+                  { return a.start < b.start; });
+        size_t merged = 0;
+        for (size_t i = 1; i < ranges.size(); ++i)
+        {
+            auto &last = ranges[merged];
+            if (ranges[i].start <= last.end)
+                last.end = std::max(last.end, ranges[i].end);
+            else
+                ranges[++merged] = ranges[i];
+        }
+        ranges.resize(merged + 1);
+        if (ranges.size() > kMaxFileRanges)
+        {
+            ranges.clear();
+            return FileRangeParseResult::InvalidRange;
+        }
+        return ranges.size() == 1 ? FileRangeParseResult::SinglePart
+                                  : FileRangeParseResult::MultiPart;
+    }
+}
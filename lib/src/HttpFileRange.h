@@ -0,0 +1,45 @@
+/**
+ * @file HttpFileRange.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-22
+ *
+ *
+ */
+
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+namespace xiaoHttp
+{
+    // A range of bytes, [start, end)
+    struct FileRange
+    {
+        size_t start;
+        size_t end;
+    };
+
+    enum class FileRangeParseResult
+    {
+        InvalidRange = -1, // the header is ignored
+        NotSatisfiable = 0,
+        SinglePart = 1,
+        MultiPart = 2
+    };
+
+    /**
+     * @brief Parse the value of a Range header, rfc9110-14.2.
+     *
+     * The satisfiable ranges are sorted and the overlapping ones are merged,
+     * a header with more than kMaxFileRanges of them, or more than twice
+     * as many range specs before the merge, is ignored.
+     */
+    FileRangeParseResult parseRangeHeader(std::string_view range,
+                                          size_t contentLength,
+                                          std::vector<FileRange> &ranges);
+
+    constexpr size_t kMaxFileRanges = 64;
+}
@@ -0,0 +1,254 @@
+/**
+ * @file HttpHeaderScanner.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-08
+ *
+ *
+ */
+
+#include "HttpHeaderScanner.h"
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define XIAOHTTP_SCANNER_X86 1
+#endif
+
+using namespace xiaoHttp;
+
+namespace
+{
+    using FindFirstOfFunc = const char *(*)(const char *,
+                                            const char *,
+                                            char,
+                                            char,
+                                            char);
+
+    const char *findFirstOfScalar(const char *p,
+                                  const char *end,
+                                  char a,
+                                  char b,
+                                  char c)
+    {
+        for (; p < end; ++p)
+        {
+            const char ch = *p;
+            if (ch == a || ch == b || ch == c)
+                return p;
+        }
+        return nullptr;
+    }
+
+#ifdef XIAOHTTP_SCANNER_X86
+    // SSE2 is part of the x86-64 baseline, so no target attribute is needed.
+    const char *findFirstOfSse2(const char *p,
+                                const char *end,
+                                char a,
+                                char b,
+                                char c)
+    {
+        const __m128i va = _mm_set1_epi8(a);
+        const __m128i vb = _mm_set1_epi8(b);
+        const __m128i vc = _mm_set1_epi8(c);
+        while (end - p >= 16)
+        {
+            const __m128i v =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            const __m128i eq =
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va),
+                                          _mm_cmpeq_epi8(v, vb)),
+                             _mm_cmpeq_epi8(v, vc));
+            const unsigned mask =
+                static_cast<unsigned>(_mm_movemask_epi8(eq));
+            if (mask)
+                return p + __builtin_ctz(mask);
+            p += 16;
+        }
+        return findFirstOfScalar(p, end, a, b, c);
+    }
+
+    __attribute__((target("avx2"))) const char *findFirstOfAvx2(
+        const char *p,
+        const char *end,
+        char a,
+        char b,
+        char c)
+    {
+        const __m256i va = _mm256_set1_epi8(a);
+        const __m256i vb = _mm256_set1_epi8(b);
+        const __m256i vc = _mm256_set1_epi8(c);
+        while (end - p >= 32)
+        {
+            const __m256i v =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            const __m256i eq =
+                _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, va),
+                                                _mm256_cmpeq_epi8(v, vb)),
+                                _mm256_cmpeq_epi8(v, vc));
+            const unsigned mask =
+                static_cast<unsigned>(_mm256_movemask_epi8(eq));
+            if (mask)
+                return p + __builtin_ctz(mask);
+            p += 32;
+        }
+        return findFirstOfSse2(p, end, a, b, c);
+    }
+#endif
+
+    struct ScannerImpl
+    {
+        FindFirstOfFunc findFirstOf;
+        const char *name;
+    };
+
+    const ScannerImpl &scannerImpl()
+    {
+        static const ScannerImpl impl = []() -> ScannerImpl
+        {
+#ifdef XIAOHTTP_SCANNER_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+                return {findFirstOfAvx2, "avx2"};
+            return {findFirstOfSse2, "sse2"};
+#else
+            return {findFirstOfScalar, "scalar"};
+#endif
+        }();
+        return impl;
+    }
+}
+
+const char *HttpHeaderScanner::findFirstOf(const char *begin,
+                                           const char *end,
+                                           char a,
+                                           char b,
+                                           char c)
+{
+    return scannerImpl().findFirstOf(begin, end, a, b, c);
+}
+
+const char *HttpHeaderScanner::findCRLF(const char *begin, const char *end)
+{
+    // memchr is already vectorized by the C library.
+    const char *p = begin;
+    while (p < end)
+    {
+        auto lf = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (!lf)
+            return nullptr;
+        if (lf != begin && *(lf - 1) == '\r')
+            return lf - 1;
+        p = lf + 1;
+    }
+    return nullptr;
+}
+
+const char *HttpHeaderScanner::implementation()
+{
+    return scannerImpl().name;
+}
+
+HttpHeadScanResult HttpHeaderScanner::scanRequestHead(
+    const char *begin,
+    const char *end,
+    HttpRequestHeadOffsets &offsets)
+{
+    constexpr auto npos = HttpRequestHeadOffsets::npos;
+    if (offsets.headEnd != npos)
+        offsets.reset();
+    auto find = scannerImpl().findFirstOf;
+    // Every search goes on from where the last call stopped, so a head that
+    // arrives in small pieces is still scanned once.
+    auto incomplete = [&offsets, begin, end]()
+    {
+        offsets.scanPos = end - begin;
+        return HttpHeadScanResult::kIncomplete;
+    };
+
+    // Request line: method SP request-target SP HTTP-version CRLF
+    if (offsets.methodEnd == npos)
+    {
+        const char *space = find(begin + offsets.scanPos, end, ' ', '\n', '\n');
+        if (!space)
+            return incomplete();
+        if (*space == '\n' || space == begin)
+            return HttpHeadScanResult::kMalformed;
+        offsets.methodEnd = space - begin;
+        offsets.targetBegin = offsets.methodEnd + 1;
+        offsets.scanPos = offsets.targetBegin;
+    }
+    while (offsets.targetEnd == npos)
+    {
+        // Only the first '?' starts the query
+        const char *token = find(begin + offsets.scanPos,
+                                 end,
+                                 ' ',
+                                 offsets.queryBegin == npos ? '?' : ' ',
+                                 '\n');
+        if (!token)
+            return incomplete();
+        if (*token == '\n')
+            return HttpHeadScanResult::kMalformed;
+        offsets.scanPos = token + 1 - begin;
+        if (*token == '?')
+            offsets.queryBegin = offsets.scanPos;
+        else
+            offsets.targetEnd = token - begin;
+    }
+    if (offsets.requestLineEnd == npos)
+    {
+        const char *lf = find(begin + offsets.scanPos, end, '\n', '\n', '\n');
+        if (!lf)
+            return incomplete();
+        if (*(lf - 1) != '\r')
+            return HttpHeadScanResult::kMalformed;
+        offsets.requestLineEnd = lf - 1 - begin;
+        offsets.lineBegin = offsets.scanPos = lf + 1 - begin;
+    }
+
+    // Header fields, terminated by an empty line
+    while (true)
+    {
+        const char *p = begin + offsets.lineBegin;
+        if (offsets.lineColon == npos)
+        {
+            if (end - p < 2)
+                return HttpHeadScanResult::kIncomplete;
+            if (p[0] == '\r' && p[1] == '\n')
+            {
+                offsets.headEnd = p + 2 - begin;
+                return HttpHeadScanResult::kComplete;
+            }
+            const char *colon =
+                find(begin + offsets.scanPos, end, ':', '\n', '\n');
+            if (!colon)
+                return incomplete();
+            if (*colon == '\n')
+            {
+                if (colon == p || *(colon - 1) != '\r')
+                    return HttpHeadScanResult::kMalformed;
+                // A field line without a colon is skipped
+                offsets.lineBegin = offsets.scanPos = colon + 1 - begin;
+                continue;
+            }
+            offsets.lineColon = colon - begin;
+            offsets.scanPos = offsets.lineColon + 1;
+        }
+        const char *lf = find(begin + offsets.scanPos, end, '\n', '\n', '\n');
+        if (!lf)
+            return incomplete();
+        if (*(lf - 1) != '\r')
+            return HttpHeadScanResult::kMalformed;
+        // A field line without a name is skipped too
+        if (offsets.lineColon != offsets.lineBegin)
+        {
+            offsets.headers.push_back({offsets.lineBegin,
+                                       offsets.lineColon,
+                                       static_cast<size_t>(lf - 1 - begin)});
+        }
+        offsets.lineBegin = offsets.scanPos = lf + 1 - begin;
+        offsets.lineColon = npos;
+    }
+}
@@ -0,0 +1,104 @@
+/**
+ * @file HttpHeaderScanner.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-08
+ *
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace xiaoHttp
+{
+    struct HttpHeaderOffsets
+    {
+        size_t fieldBegin;
+        size_t colon;
+        size_t lineEnd; // position of the CR of the line
+    };
+
+    /**
+     * @brief Offsets of the tokens in a request head, relative to the first
+     * byte of the head. A field that has not been reached yet is npos.
+     *
+     * It also keeps how far an incomplete head was scanned, the scan of the
+     * same head goes on from there when more bytes arrive.
+     */
+    struct HttpRequestHeadOffsets
+    {
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        size_t methodEnd{npos};
+        size_t targetBegin{npos};
+        size_t queryBegin{npos}; // first byte after '?'
+        size_t targetEnd{npos};
+        size_t requestLineEnd{npos};
+        size_t headEnd{npos}; // first byte after the empty line
+        std::vector<HttpHeaderOffsets> headers;
+
+        // The progress of an incomplete scan
+        size_t lineBegin{0}; // first byte of the header line being scanned
+        size_t lineColon{npos};
+        size_t scanPos{0}; // where the current search goes on
+
+        void reset()
+        {
+            methodEnd = npos;
+            targetBegin = npos;
+            queryBegin = npos;
+            targetEnd = npos;
+            requestLineEnd = npos;
+            headEnd = npos;
+            headers.clear();
+            lineBegin = 0;
+            lineColon = npos;
+            scanPos = 0;
+        }
+    };
+
+    enum class HttpHeadScanResult
+    {
+        kComplete,
+        kIncomplete,
+        kMalformed
+    };
+
+    /**
+     * @brief Tokenizes the request line and the header block in one pass.
+     *
+     * The offsets are kept between the calls for the same head, which must
+     * start at the same byte each time and only grow. They are reset once a
+     * head is complete, or with reset() for a new one. Field lines without
+     * a colon or without a name are skipped.
+     *
+     * The structural characters (SP, '?', ':' and LF) are located with
+     * SSE2 or AVX2 when the CPU supports them, the implementation is picked
+     * once at runtime. Other platforms use the scalar loop.
+     */
+    class HttpHeaderScanner
+    {
+    public:
+        static HttpHeadScanResult scanRequestHead(
+            const char *begin,
+            const char *end,
+            HttpRequestHeadOffsets &offsets);
+
+        /// Return the first occurrence of any of a, b or c, or nullptr.
+        static const char *findFirstOf(const char *begin,
+                                       const char *end,
+                                       char a,
+                                       char b,
+                                       char c);
+
+        /// Return the position of the first "\r\n", or nullptr.
+        static const char *findCRLF(const char *begin, const char *end);
+
+        /// The name of the implementation in use, for logging.
+        static const char *implementation();
+    };
+}
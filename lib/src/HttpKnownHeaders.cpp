@@ -0,0 +1,84 @@
+/**
+ * @file HttpKnownHeaders.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-09
+ *
+ *
+ */
+
+#include "HttpKnownHeaders.h"
+
+using namespace xiaoHttp;
+
+static constexpr std::string_view knownHeaderNames[kKnownHeaderCount] = {
+    "accept-encoding",
+    "connection",
+    "content-encoding",
+    "content-length",
+    "content-type",
+    "cookie",
+    "expect",
+    "host",
+    "if-match",
+    "if-modified-since",
+    "if-none-match",
+    "if-range",
+    "range",
+    "transfer-encoding",
+    "upgrade"};
+
+std::string_view xiaoHttp::knownHeaderName(KnownHeader id)
+{
+    if (id >= KnownHeader::Count)
+        return {};
+    return knownHeaderNames[static_cast<size_t>(id)];
+}
+
+KnownHeader xiaoHttp::lookupKnownHeader(std::string_view lowerName)
+{
+    // Only one comparison is made for most names, the length picks the
+    // candidate.
+    auto check = [lowerName](KnownHeader id)
+    {
+        return knownHeaderNames[static_cast<size_t>(id)] == lowerName
+                   ? id
+                   : KnownHeader::Unknown;
+    };
+    switch (lowerName.length())
+    {
+    case 4:
+        return check(KnownHeader::Host);
+    case 5:
+        return check(KnownHeader::Range);
+    case 6:
+        if (lowerName[0] == 'c')
+            return check(KnownHeader::Cookie);
+        return check(KnownHeader::Expect);
+    case 7:
+        return check(KnownHeader::Upgrade);
+    case 8:
+        if (lowerName[3] == 'm')
+            return check(KnownHeader::IfMatch);
+        return check(KnownHeader::IfRange);
+    case 10:
+        return check(KnownHeader::Connection);
+    case 12:
+        return check(KnownHeader::ContentType);
+    case 13:
+        return check(KnownHeader::IfNoneMatch);
+    case 14:
+        return check(KnownHeader::ContentLength);
+    case 15:
+        return check(KnownHeader::AcceptEncoding);
+    case 16:
+        return check(KnownHeader::ContentEncoding);
+    case 17:
+        if (lowerName[0] == 't')
+            return check(KnownHeader::TransferEncoding);
+        return check(KnownHeader::IfModifiedSince);
+    default:
+        return KnownHeader::Unknown;
+    }
+}
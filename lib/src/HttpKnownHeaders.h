@@ -0,0 +1,54 @@
+/**
+ * @file HttpKnownHeaders.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-09
+ *
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace xiaoHttp
+{
+    /**
+     * @brief Request headers that the framework looks up on every request.
+     *
+     * The parser records where each of them is in a fixed slot of the
+     * request, so looking one up is an array index instead of a hash lookup.
+     */
+    enum class KnownHeader : uint8_t
+    {
+        AcceptEncoding = 0,
+        Connection,
+        ContentEncoding,
+        ContentLength,
+        ContentType,
+        Cookie,
+        Expect,
+        Host,
+        IfMatch,
+        IfModifiedSince,
+        IfNoneMatch,
+        IfRange,
+        Range,
+        TransferEncoding,
+        Upgrade,
+        Count,
+        Unknown = Count
+    };
+
+    constexpr size_t kKnownHeaderCount =
+        static_cast<size_t>(KnownHeader::Count);
+
+    /// Return the lowercase field name of a known header.
+    std::string_view knownHeaderName(KnownHeader id);
+
+    /// Return the id of a lowercase field name, or KnownHeader::Unknown.
+    KnownHeader lookupKnownHeader(std::string_view lowerName);
+}
@@ -9,6 +9,7 @@
  */
 
 #pragma once
+#include <xiaoNet/utils/MsgBuffer.h>
 #include <string_view>
 #include <string>
 #include <memory>
@@ -22,7 +23,8 @@ namespace xiaoHttp
         {
             kNone = 0,
             kString,
-            kStringView
+            kStringView,
+            kBuffer
         };
 
         BodyType bodyType()
@@ -102,6 +104,11 @@ namespace xiaoHttp
             body_.append(buf, len);
         }
 
+        std::string &string()
+        {
+            return body_;
+        }
+
     private:
         std::string body_;
     };
@@ -137,4 +144,47 @@ namespace xiaoHttp
     private:
         std::string_view body_;
     };
-}
\ No newline at end of file
+
+    // The json body of a response, serialized straight into the buffer
+    class HttpMessageBufferBody : public HttpMessageBody
+    {
+    public:
+        HttpMessageBufferBody()
+        {
+            type_ = BodyType::kBuffer;
+        }
+
+        const char *data() const override
+        {
+            return body_.peek();
+        }
+
+        char *data() override
+        {
+            return const_cast<char *>(body_.peek());
+        }
+
+        size_t length() const override
+        {
+            return body_.readableBytes();
+        }
+
+        std::string_view getString() const override
+        {
+            return std::string_view{body_.peek(), body_.readableBytes()};
+        }
+
+        void append(const char *buf, size_t len) override
+        {
+            body_.append(buf, len);
+        }
+
+        xiaoNet::MsgBuffer &buffer()
+        {
+            return body_;
+        }
+
+    private:
+        xiaoNet::MsgBuffer body_;
+    };
+}
@@ -10,6 +10,8 @@
 
 #include "HttpRequestImpl.h"
 #include "HttpAppFrameworkImpl.h"
+#include <algorithm>
+#include <cstring>
 
 using namespace xiaoHttp;
 
@@ -19,23 +21,16 @@ void HttpRequestImpl::parseJson() const
     if (input.empty())
         return;
     if (contentType_ == CT_APPLICATION_JSON ||
-        getHeaderBy("content-type").find("application/json") !=
+        getHeaderView(KnownHeader::ContentType).find("application/json") !=
             std::string::npos)
     {
-        static std::once_flag once;
-        static Json::CharReaderBuilder builder;
-        std::call_once(once, []()
-                       { builder["collectComments"] = false;
-                       builder["stackLimit"] = static_cast<Json::UInt>(
-                        xiaoHttp::app().getJsonParseStackLimit()
-                       ); });
         jsonPtr_ = std::make_shared<Json::Value>();
-        JSONCPP_STRING errs;
-        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
-        if (!reader->parse(input.data(),
-                           input.data() + input.size(),
-                           jsonPtr_.get(),
-                           &errs))
+        std::string errs;
+        auto &backend = HttpAppFrameworkImpl::instance().getJsonBackend();
+        if (!backend->parse(input.data(),
+                            input.data() + input.size(),
+                            *jsonPtr_,
+                            errs))
         {
             LOG_DEBUG << errs;
             jsonPtr_.reset();
@@ -55,121 +50,98 @@ void HttpRequestImpl::parseJson() const
     }
 }
 
-void HttpRequestImpl::parseParameters() const
+// Call cb(key, value) for every pair of an urlencoded string, both are
+// still encoded. A pair without '=' has an empty value.
+template <typename Callback>
+static void forEachUrlEncodedPair(std::string_view input, Callback &&cb)
 {
-    auto input = queryView();
-    if (!input.empry())
+    size_t pos = 0;
+    while (pos < input.length() &&
+           (input[pos] == '?' ||
+            isspace(static_cast<unsigned char>(input[pos]))))
+        ++pos;
+    input.remove_prefix(pos);
+    while (!input.empty())
     {
-        std::string_view::size_type pos = 0;
-        while ((input[pos] == '?' ||
-                isspace(static_cast<unsigned char>(input[pos]))) &&
-               pos < input.length())
+        auto amp = input.find('&');
+        auto pair = input.substr(0, amp);
+        input.remove_prefix(amp == std::string_view::npos ? input.length()
+                                                          : amp + 1);
+        auto equal = pair.find('=');
+        if (equal == std::string_view::npos)
         {
-            ++pos;
-        }
-        auto value = input.substr(pos);
-        while ((pos == value.find('&')) != std::string_view::npos)
-        {
-            auto coo = value.substr(0, pos);
-            auto epos = coo.find('=');
-            if (epos != std::string_view::npos)
-            {
-                auto key = coo.substr(0, epos);
-                std::string_view::size_type cpos = 0;
-                while (cops < key.length() &&
-                       isspace(static_cast<unsigned char>(key[cpos])))
-                    ++cpos;
-                key.remove_prefix(cpos);
-                auto pvalue = coo.substr(epos + 1);
-                parameters_[utils::urlDecode(key)] = utils::urlDecode(pvalue);
-            }
-            else
-            {
-                parameters_[utils::urlDecode(coo)];
-            }
-            value.remove_prefix(pos + 1);
-        }
-        if (value.length() > 0)
-        {
-            auto &coo = value;
-            auto epos = coo.find('=');
-            if (epos != std::string_view::npos)
-            {
-                auto key = coo.substr(0, epos);
-                std::string_view::size_type cpos = 0;
-                while (cpos < key.length() &&
-                       isspace(static_cast<unsigned char>(key[cpos])))
-                    ++cpos;
-                key.remove_prefix(cpos);
-                auto pvalue = coo.substr(epos + 1);
-                parameters_[utils::urlDecode(key)] = utils::urlDecode(pvalue);
-            }
-            else
-            {
-                parameters_[utils::urlDecode(coo)];
-            }
+            cb(pair, std::string_view{});
+            continue;
         }
+        auto key = pair.substr(0, equal);
+        size_t cpos = 0;
+        while (cpos < key.length() &&
+               isspace(static_cast<unsigned char>(key[cpos])))
+            ++cpos;
+        key.remove_prefix(cpos);
+        cb(key, pair.substr(equal + 1));
     }
+}
 
-    input = contentView();
+// Whether an encoded key is the decoded one, the key is only decoded when
+// it holds escapes.
+static bool urlEncodedKeyEquals(std::string_view encoded, std::string_view key)
+{
+    if (!utils::needUrlDecoding(encoded.data(),
+                                encoded.data() + encoded.length()))
+        return encoded == key;
+    // An escape only makes the key shorter
+    if (encoded.length() < key.length())
+        return false;
+    return utils::urlDecode(encoded) == key;
+}
+
+std::string_view HttpRequestImpl::urlEncodedContentView() const
+{
+    auto input = contentView();
     if (input.empty())
-        return;
-    std::string type = getHeaderBy("content-type");
+        return {};
+    std::string type(getHeaderView(KnownHeader::ContentType));
     std::transform(type.begin(), type.end(), type.begin(), [](unsigned char c)
                    { return tolower(c); });
     if (type.empty() ||
         type.find("application/x-www-form-urlencoded") != std::string::npos)
+        return input;
+    return {};
+}
+
+void HttpRequestImpl::parseParameters() const
+{
+    auto insert = [this](std::string_view key, std::string_view value)
+    { parameters_[utils::urlDecode(key)] = utils::urlDecode(value); };
+    forEachUrlEncodedPair(queryView(), insert);
+    forEachUrlEncodedPair(urlEncodedContentView(), insert);
+}
+
+const std::string *HttpRequestImpl::findParameter(const std::string &key) const
+{
+    // Values are cached in the map as they are looked up
+    auto iter = parameters_.find(key);
+    if (iter != parameters_.end())
+        return &iter->second;
+    // The last occurrence wins, like in parseParameters(), only the value
+    // of the key that is asked for is decoded.
+    std::string_view found;
+    bool hasFound = false;
+    auto match = [&](std::string_view encodedKey, std::string_view value)
     {
-        std::string_view::size_type pos = 0;
-        while ((input[pos] == '?' ||
-                isspace(static_cast<unsigned char>(input[pos]))) &&
-               pos < input.length())
+        if (urlEncodedKeyEquals(encodedKey, key))
         {
-            ++pos;
-        }
-        auto value = input.substr(pos);
-        while ((pos = value.find('&')) != std::string_view::npos)
-        {
-            auto coo = value.substr(0, pos);
-            auto epos = coo.find('=');
-            if (epos != std::string_view::npos)
-            {
-                auto key = coo.substr(0, epos);
-                std::string_view::size_type cpos = 0;
-                while (cpos < key.length() &&
-                       isspace(static_cast<unsigned char>(key[cpos])))
-                    ++cpos;
-                key.remove_prefix(cpos);
-                auto pvalue = coo.substr(epos + 1);
-                parameters_[utils::urlDecode(key)] = utils::urlDecode(pvalue);
-            }
-            else
-            {
-                parameters_[utils::urlDecode(coo)];
-            }
-            value.remove_prefix(pos + 1);
-        }
-        if (value.length() > 0)
-        {
-            auto &coo = value;
-            auto epos = coo.find('=');
-            if (epos != std::string_view::npos)
-            {
-                auto key = coo.substr(0, epos);
-                std::string_view::size_type cpos = 0;
-                while (cpos < key.length() &&
-                       isspace(static_cast<unsigned char>(key[cpos])))
-                    ++cpos;
-                key.remove_prefix(cpos);
-                auto pvalue = coo.substr(epos + 1);
-                parameters_[utils::urlDecode(key)] = utils::urlDecode(pvalue);
-            }
-            else
-            {
-                parameters_[utils::urlDecode(coo)];
-            }
+            found = value;
+            hasFound = true;
         }
-    }
+    };
+    forEachUrlEncodedPair(queryView(), match);
+    forEachUrlEncodedPair(urlEncodedContentView(), match);
+    if (!hasFound)
+        return nullptr;
+    return &parameters_.insert_or_assign(key, utils::urlDecode(found))
+                .first->second;
 }
 
 const char *HttpRequestImpl::versionString() const
@@ -302,7 +274,10 @@ void HttpRequestImpl::appendToBody(const char *data, size_t length)
     if (streamReaderPtr_)
     {
         assert(streamStatus_ == ReqStreamStatus::Open);
-        streamReaderPtr_->onStreamData(data, length);
+        if (flowControl_)
+            feedStreamReader(data, length);
+        else
+            streamReaderPtr_->onStreamData(data, length);
     }
     else if (cacheFilePtr_)
     {
@@ -340,112 +315,174 @@ void HttpRequestImpl::reserveBodySize(size_t length)
     {
         // Store data of body to a temporary file
         createTmpFile();
+        cacheFilePtr_->reserve(length);
     }
 }
 
-void HttpRequestImpl::addHeader(const char *start,
-                                const char *colon,
-                                const char *end)
+void HttpRequestImpl::setRawHeaders(const char *head,
+                                    const HttpRequestHeadOffsets &offsets)
 {
-    std::string field(start, colon);
-    // Field name is case-insensitive.so we transform it to lower;(rfc2616-4.2)
-    std::transform(field.begin(),
-                   field.end(),
-                   field.begin(),
-                   [](unsigned char c)
-                   { return tolower(c); });
-    ++colon;
-    while (colon < end && isspace(static_cast<unsigned char>(*colon)))
-    {
-        ++colon;
-    }
-    std::string value(colon, end);
-    while (!value.empty() &&
-           isspace(static_cast<unsigned char>(value[value.size() - 1])))
-    {
-        value.resize(value.size() - 1);
-    }
-    if (field.length() == 6 && field == "cookie")
+    if (offsets.headers.empty())
+        return;
+    const size_t base = offsets.headers.front().fieldBegin;
+    rawHeaders_.assign(head + base, head + offsets.headEnd);
+    rawHeaderFields_.reserve(offsets.headers.size());
+    char *data = rawHeaders_.data();
+    for (auto &header : offsets.headers)
     {
-        LOG_TRACE << "cookies!!!:" << value;
-        std::string::size_type pos;
-        while ((pos = value.find(';')) != std::string::npos)
+        size_t nameBegin = header.fieldBegin - base;
+        size_t nameEnd = header.colon - base;
+        // Field name is case-insensitive.so we transform it to lower;(rfc2616-4.2)
+        std::transform(data + nameBegin,
+                       data + nameEnd,
+                       data + nameBegin,
+                       [](unsigned char c)
+                       { return tolower(c); });
+        size_t valueBegin = nameEnd + 1;
+        size_t valueEnd = header.lineEnd - base;
+        while (valueBegin < valueEnd &&
+               isspace(static_cast<unsigned char>(data[valueBegin])))
         {
-            std::string coo = value.substr(0, pos);
-            auto epos = coo.find('=');
-            if (epos != std::string::npos)
-            {
-                std::string cookie_name = coo.substr(0, epos);
-                std::string::size_type cpos = 0;
-                while (cpos < cookie_name.length() &&
-                       isspace(static_cast<unsigned char>(cookie_name[cpos])))
-                    ++cpos;
-                cookie_name = cookie_name.substr(cpos);
-                std::string cookie_value = coo.substr(epos + 1);
-                cpos = 0;
-                while (cpos < cookie_value.length() &&
-                       isspace(static_cast<unsigned char>(cookie_value[cpos])))
-                    ++cpos;
-                cookie_value = cookie_value.substr(cpos);
-                cookies_[std::move(cookie_name)] = std::move(cookie_value);
-            }
-            value = value.substr(pos + 1);
+            ++valueBegin;
         }
-        if (value.length() > 0)
+        while (valueEnd > valueBegin &&
+               isspace(static_cast<unsigned char>(data[valueEnd - 1])))
         {
-            std::string &coo = value;
-            auto epos = coo.find('=');
-            if (epos != std::string::npos)
+            --valueEnd;
+        }
+        std::string_view field(data + nameBegin, nameEnd - nameBegin);
+        std::string_view value(data + valueBegin, valueEnd - valueBegin);
+        auto id = lookupKnownHeader(field);
+        switch (id)
+        {
+        case KnownHeader::Cookie:
+            parseCookies(std::string(value));
+            continue;
+        case KnownHeader::Expect:
+            expectPtr_ = std::make_unique<std::string>(value);
+            break;
+        case KnownHeader::Connection:
+            if (version_ == Version::kHttp11)
+            {
+                if (value.length() == 5 && value == "close")
+                    keepAlive_ = false;
+            }
+            else if (value.length() == 10 &&
+                     (value == "Keep-Alive" || value == "keep-alive"))
             {
-                std::string cookie_name = coo.substr(0, epos);
-                std::string::size_type cpos = 0;
-                while (cpos < cookie_name.length() &&
-                       isspace(static_cast<unsigned char>(cookie_name[cpos])))
-                    ++cpos;
-                cookie_name = cookie_name.substr(cpos);
-                std::string cookie_value = coo.substr(epos + 1);
-                cpos = 0;
-                while (cpos < cookie_value.length() &&
-                       isspace(static_cast<unsigned char>(cookie_value[cpos])))
-                    ++cpos;
-                cookie_value = cookie_value.substr(cpos);
-                cookies_[std::move(cookie_name)] = std::move(cookie_value);
+                keepAlive_ = true;
             }
+            break;
+        default:
+            break;
+        }
+        if (id != KnownHeader::Unknown &&
+            knownHeaderSlots_[static_cast<size_t>(id)] == kNoHeaderSlot)
+        {
+            knownHeaderSlots_[static_cast<size_t>(id)] =
+                static_cast<uint32_t>(rawHeaderFields_.size());
         }
+        rawHeaderFields_.push_back({static_cast<uint32_t>(nameBegin),
+                                    static_cast<uint32_t>(field.length()),
+                                    static_cast<uint32_t>(valueBegin),
+                                    static_cast<uint32_t>(value.length())});
     }
-    else
+}
+
+void HttpRequestImpl::parseCookies(std::string value)
+{
+    LOG_TRACE << "cookies!!!:" << value;
+    std::string::size_type pos;
+    while ((pos = value.find(';')) != std::string::npos)
     {
-        switch (field.length())
+        std::string coo = value.substr(0, pos);
+        auto epos = coo.find('=');
+        if (epos != std::string::npos)
         {
-        case 6:
-            if (field == "expect")
-            {
-                expectPtr_ = std::make_unique<std::string>(value);
-            }
-            break;
-        case 10:
+            std::string cookie_name = coo.substr(0, epos);
+            std::string::size_type cpos = 0;
+            while (cpos < cookie_name.length() &&
+                   isspace(static_cast<unsigned char>(cookie_name[cpos])))
+                ++cpos;
+            cookie_name = cookie_name.substr(cpos);
+            std::string cookie_value = coo.substr(epos + 1);
+            cpos = 0;
+            while (cpos < cookie_value.length() &&
+                   isspace(static_cast<unsigned char>(cookie_value[cpos])))
+                ++cpos;
+            cookie_value = cookie_value.substr(cpos);
+            cookies_[std::move(cookie_name)] = std::move(cookie_value);
+        }
+        value = value.substr(pos + 1);
+    }
+    if (value.length() > 0)
+    {
+        std::string &coo = value;
+        auto epos = coo.find('=');
+        if (epos != std::string::npos)
         {
-            if (field == "connection")
-            {
-                if (version_ == Version::kHttp11)
-                {
-                    if (value.length() == 5 && value == "close")
-                        keepAlive_ = false;
-                }
-                else if (value.length() == 10 &&
-                         (value == "Keep-Alive" || value == "keep-alive"))
-                {
-                    keepAlive_ = true;
-                }
-            }
+            std::string cookie_name = coo.substr(0, epos);
+            std::string::size_type cpos = 0;
+            while (cpos < cookie_name.length() &&
+                   isspace(static_cast<unsigned char>(cookie_name[cpos])))
+                ++cpos;
+            cookie_name = cookie_name.substr(cpos);
+            std::string cookie_value = coo.substr(epos + 1);
+            cpos = 0;
+            while (cpos < cookie_value.length() &&
+                   isspace(static_cast<unsigned char>(cookie_value[cpos])))
+                ++cpos;
+            cookie_value = cookie_value.substr(cpos);
+            cookies_[std::move(cookie_name)] = std::move(cookie_value);
         }
-        break;
+    }
+}
 
-        default:
-            break;
+void HttpRequestImpl::materializeHeaders() const
+{
+    if (headersMaterialized_)
+        return;
+    headersMaterialized_ = true;
+    const char *data = rawHeaders_.data();
+    for (auto &field : rawHeaderFields_)
+    {
+        // emplace() keeps the first occurrence of a repeated field
+        headers_.emplace(std::string(data + field.nameBegin, field.nameLength),
+                         std::string(data + field.valueBegin,
+                                     field.valueLength));
+    }
+}
+
+std::string_view HttpRequestImpl::getHeaderViewBy(
+    std::string_view lowerField) const
+{
+    if (headersMaterialized_)
+    {
+        auto it = headers_.find(std::string(lowerField));
+        if (it != headers_.end())
+        {
+            return it->second;
         }
-        headers_.emplace(std::move(field), std::move(value));
+        return {};
+    }
+    auto id = lookupKnownHeader(lowerField);
+    if (id != KnownHeader::Unknown)
+    {
+        return getHeaderView(id);
     }
+    const char *data = rawHeaders_.data();
+    for (auto &field : rawHeaderFields_)
+    {
+        if (field.nameLength == lowerField.length() &&
+            memcmp(data + field.nameBegin,
+                   lowerField.data(),
+                   lowerField.length()) == 0)
+        {
+            return std::string_view(data + field.valueBegin,
+                                    field.valueLength);
+        }
+    }
+    return {};
 }
 
 void HttpRequestImpl::swap(HttpRequestImpl &that) noexcept
@@ -461,6 +498,10 @@ void HttpRequestImpl::swap(HttpRequestImpl &that) noexcept
     swap(pathEncode_, that.pathEncode_);
     swap(query_, that.query_);
     swap(headers_, that.headers_);
+    swap(rawHeaders_, that.rawHeaders_);
+    swap(rawHeaderFields_, that.rawHeaderFields_);
+    swap(knownHeaderSlots_, that.knownHeaderSlots_);
+    swap(headersMaterialized_, that.headersMaterialized_);
     swap(cookies_, that.cookies_);
     swap(contentLengthHeaderValue_, that.contentLengthHeaderValue_);
     swap(realContentLength_, that.realContentLength_);
@@ -486,6 +527,10 @@ void HttpRequestImpl::swap(HttpRequestImpl &that) noexcept
     swap(streamReaderPtr_, that.streamReaderPtr_);
     swap(streamFinishCb_, that.streamFinishCb_);
     swap(streamExceptionPtr_, that.streamExceptionPtr_);
+    swap(flowControl_, that.flowControl_);
+    swap(readingPaused_, that.readingPaused_);
+    swap(streamCredit_, that.streamCredit_);
+    swap(pendingStreamData_, that.pendingStreamData_);
     swap(startProcessing_, that.startProcessing_);
     swap(connPtr_, that.connPtr_);
 }
@@ -678,6 +723,7 @@ void HttpRequestImpl::appendToBuffer(xiaoNet::MsgBuffer *output) const
             output->append("\r\n");
         }
     }
+    materializeHeaders();
     for (auto it = headers_.begin(); it != headers_.end(); ++it)
     {
         output->append(it->first);
@@ -872,17 +918,138 @@ void HttpRequestImpl::setStreamReader(RequestStreamReaderPtr reader)
     }
 }
 
+void HttpRequestImpl::setStreamReader(RequestStreamReaderPtr reader,
+                                      size_t initialCredit)
+{
+    assert(loop_->isInLoopThread());
+    assert(!streamReaderPtr_);
+    assert(streamStatus_ > ReqStreamStatus::None);
+
+    if (streamExceptionPtr_)
+    {
+        assert(streamStatus_ == ReqStreamStatus::Error);
+        reader->onStreamFinish(std::move(streamExceptionPtr_));
+        streamExceptionPtr_ = nullptr;
+        return;
+    }
+
+    flowControl_ = true;
+    streamCredit_ = initialCredit;
+    streamReaderPtr_ = std::move(reader);
+    // The body received before the reader waits for credit like the rest
+    if (cacheFilePtr_)
+    {
+        pendingStreamData_.assign(cacheFilePtr_->getStringView());
+        cacheFilePtr_.reset();
+    }
+    else
+    {
+        pendingStreamData_.swap(content_);
+        content_.clear();
+    }
+    deliverPendingStreamData();
+}
+
+void HttpRequestImpl::grantStreamCredit(size_t bytes)
+{
+    assert(loop_->isInLoopThread());
+    if (!flowControl_ || !streamReaderPtr_)
+        return;
+    streamCredit_ += bytes;
+    deliverPendingStreamData();
+}
+
+void HttpRequestImpl::feedStreamReader(const char *data, size_t length)
+{
+    if (pendingStreamData_.empty())
+    {
+        auto granted = std::min(length, streamCredit_);
+        streamCredit_ -= granted;
+        if (granted > 0)
+            streamReaderPtr_->onStreamData(data, granted);
+        data += granted;
+        length -= granted;
+    }
+    // What is left is the rest of the current read of the socket, the
+    // connection reads no more until the reader grants credit.
+    pendingStreamData_.append(data, length);
+    if (streamCredit_ == 0)
+        pauseReading();
+}
+
+void HttpRequestImpl::deliverPendingStreamData()
+{
+    if (!pendingStreamData_.empty() && streamCredit_ > 0)
+    {
+        auto granted = std::min(pendingStreamData_.size(), streamCredit_);
+        streamCredit_ -= granted;
+        streamReaderPtr_->onStreamData(pendingStreamData_.data(), granted);
+        pendingStreamData_.erase(0, granted);
+    }
+    if (!pendingStreamData_.empty())
+    {
+        pauseReading();
+        return;
+    }
+    if (streamStatus_ == ReqStreamStatus::Finish)
+    {
+        // The finish was held back behind the data
+        auto reader = std::move(streamReaderPtr_);
+        streamReaderPtr_ = nullptr;
+        resumeReading();
+        reader->onStreamFinish({});
+        if (streamFinishCb_)
+        {
+            auto cb = std::move(streamFinishCb_);
+            streamFinishCb_ = nullptr;
+            cb();
+        }
+        return;
+    }
+    if (streamCredit_ > 0)
+        resumeReading();
+    else
+        pauseReading();
+}
+
+void HttpRequestImpl::pauseReading()
+{
+    if (readingPaused_)
+        return;
+    if (auto conn = connPtr_.lock())
+    {
+        conn->stopRead();
+        readingPaused_ = true;
+    }
+}
+
+void HttpRequestImpl::resumeReading()
+{
+    if (!readingPaused_)
+        return;
+    readingPaused_ = false;
+    if (auto conn = connPtr_.lock())
+        conn->startRead();
+}
+
 void HttpRequestImpl::streamStart()
 {
     assert(streamStatus_ == ReqStreamStatus::None);
     streamStatus_ = ReqStreamStatus::Open;
 }
 
-void HttpRequestImpl::startFinish()
+void HttpRequestImpl::streamFinish()
 {
     assert(loop_->isInLoopThread());
     assert(streamStatus_ == ReqStreamStatus::Open);
     streamStatus_ = ReqStreamStatus::Finish;
+    if (streamReaderPtr_ && flowControl_)
+    {
+        // Finishes now unless data is still waiting for credit, the stream
+        // is not over for the server before the reader has it all.
+        deliverPendingStreamData();
+        return;
+    }
     if (streamFinishCb_)
     {
         auto cb = std::move(streamFinishCb_);
@@ -904,6 +1071,8 @@ void HttpRequestImpl::streamError(std::exception_ptr ex)
     assert(loop_->isInLoopThread());
     assert(streamStatus_ == ReqStreamStatus::Open);
     streamStatus_ = ReqStreamStatus::Error;
+    pendingStreamData_.clear();
+    resumeReading();
     if (streamReaderPtr_)
     {
         streamReaderPtr_->onStreamFinish(std::move(ex));
@@ -927,7 +1096,10 @@ void HttpRequestImpl::waitForStreamFinish(std::function<void()> &&cb)
     assert(loop_->isInLoopThread());
     assert(streamStatus_ > ReqStreamStatus::None);
 
-    if (streamStatus_ <= ReqStreamStatus::Open)
+    // With flow control the reader may still be waiting for the last bytes
+    if (streamStatus_ <= ReqStreamStatus::Open ||
+        (streamStatus_ == ReqStreamStatus::Finish && streamReaderPtr_ &&
+         flowControl_))
     {
         assert(!streamFinishCb_); // should only be called once
         streamFinishCb_ = std::move(cb);
@@ -942,6 +1114,17 @@ void HttpRequestImpl::quitStreamMode()
 {
     assert(loop_->isInLoopThread());
     assert(streamStatus_ >= ReqStreamStatus::Finish);
-    assert(!streamReaderPtr_);
+    if (streamReaderPtr_)
+    {
+        // The reader stopped granting credit before the end of the body
+        assert(flowControl_);
+        pendingStreamData_.clear();
+        resumeReading();
+        auto reader = std::move(streamReaderPtr_);
+        streamReaderPtr_ = nullptr;
+        reader->onStreamFinish(std::make_exception_ptr(
+            StreamError(StreamErrorCode::kConnectionBroken,
+                        "Request stream closed before it was read")));
+    }
     streamStatus_ = ReqStreamStatus::None;
 }
@@ -12,6 +12,8 @@
 
 #include "HttpUtils.h"
 #include "CacheFile.h"
+#include "HttpHeaderScanner.h"
+#include "HttpKnownHeaders.h"
 
 #include <xiaoHttp/HttpRequest.h>
 #include <xiaoHttp/RequestStream.h>
@@ -20,6 +22,8 @@
 #include <xiaoNet/net/EventLoop.h>
 #include <xiaoNet/net/TcpConnection.h>
 #include <xiaoNet/utils/MsgBuffer.h>
+#include <array>
+#include <cstdint>
 
 namespace xiaoHttp
 {
@@ -56,6 +60,10 @@ namespace xiaoHttp
             version_ = Version::kUnKnown;
             flagForParsingJson_ = false;
             headers_.clear();
+            rawHeaders_.clear();
+            rawHeaderFields_.clear();
+            knownHeaderSlots_.fill(kNoHeaderSlot);
+            headersMaterialized_ = false;
             cookies_.clear();
             flagForParsingParameters_ = false;
             path_.clear();
@@ -66,7 +74,12 @@ namespace xiaoHttp
             parameters_.clear();
             jsonPtr_.reset();
             sessionPtr_.reset();
-            attributesPtr_.reset();
+            // The attributes are kept for the next request unless they are
+            // still referenced elsewhere
+            if (attributesPtr_.use_count() == 1)
+                attributesPtr_->clear();
+            else
+                attributesPtr_.reset();
             cacheFilePtr_.reset();
             expectPtr_.reset();
             content_.clear();
@@ -82,6 +95,10 @@ namespace xiaoHttp
             streamReaderPtr_.reset();
             streamFinishCb_ = nullptr;
             streamExceptionPtr_ = nullptr;
+            flowControl_ = false;
+            readingPaused_ = false;
+            streamCredit_ = 0;
+            pendingStreamData_.clear();
             startProcessing_ = false;
             connPtr_.reset();
         }
@@ -182,7 +199,13 @@ namespace xiaoHttp
         const std::string &getParameter(const std::string &key) const override
         {
             static const std::string defaultVal;
-            parseParametersOnce();
+            if (!flagForParsingParameters_)
+            {
+                // Only the asked key is decoded until the whole map is
+                // wanted
+                auto value = findParameter(key);
+                return value ? *value : defaultVal;
+            }
             auto iter = parameters_.find(key);
             if (iter != parameters_.end())
                 return iter->second;
@@ -313,7 +336,15 @@ namespace xiaoHttp
             peerCertificate_ = cert;
         }
 
-        void addHeader(const char *start, const char *colon, const char *end);
+        /**
+         * @brief Take the header block tokenized by HttpRequestParser.
+         *
+         * The block is copied once into the request and the field names are
+         * lowercased in place. The headers are kept as views into the block,
+         * the header map is only built when it is asked for or modified.
+         */
+        void setRawHeaders(const char *head,
+                           const HttpRequestHeadOffsets &offsets);
 
         void removeHeader(std::string key) override
         {
@@ -324,6 +355,7 @@ namespace xiaoHttp
 
         void removeHeaderBy(const std::string &lowerKey)
         {
+            materializeHeaders();
             headers_.erase(lowerKey);
         }
 
@@ -340,6 +372,7 @@ namespace xiaoHttp
         const std::string &getHeaderBy(const std::string &lowerField) const
         {
             static const std::string defaultVal;
+            materializeHeaders();
             auto it = headers_.find(lowerField);
             if (it != headers_.end())
             {
@@ -348,6 +381,35 @@ namespace xiaoHttp
             return defaultVal;
         }
 
+        /**
+         * @brief Get the value of a header without building the header map.
+         *
+         * @param lowerField The lowercase field name.
+         * @return An empty view if the header does not exist. The view is
+         * valid until the request is reset or its headers are modified.
+         */
+        std::string_view getHeaderViewBy(std::string_view lowerField) const;
+
+        /**
+         * @brief Get the value of a well-known header, this is an array index
+         * for a request that came from the parser.
+         */
+        std::string_view getHeaderView(KnownHeader id) const
+        {
+            if (headersMaterialized_)
+            {
+                return getHeaderViewBy(knownHeaderName(id));
+            }
+            auto slot = knownHeaderSlots_[static_cast<size_t>(id)];
+            if (slot == kNoHeaderSlot)
+            {
+                return {};
+            }
+            auto &field = rawHeaderFields_[slot];
+            return std::string_view(rawHeaders_.data() + field.valueBegin,
+                                    field.valueLength);
+        }
+
         const std::string &getCookie(const std::string &field) const override
         {
             static const std::string defaultVal;
@@ -361,6 +423,7 @@ namespace xiaoHttp
 
         const SafeStringMap<std::string> &headers() const override
         {
+            materializeHeaders();
             return headers_;
         }
 
@@ -381,7 +444,8 @@ namespace xiaoHttp
 
         void setParameter(const std::string &key, const std::string &value) override
         {
-            flagForParsingParameters_ = true;
+            // The lazy lookups may have cached only some of the parameters
+            parseParametersOnce();
             parameters_[key] = value;
         }
 
@@ -414,6 +478,7 @@ namespace xiaoHttp
                            field.begin(),
                            [](unsigned char c)
                            { return tolower(c); });
+            materializeHeaders();
             headers_[std::move(field)] = value;
         }
 
@@ -424,6 +489,7 @@ namespace xiaoHttp
                            field.begin(),
                            [](unsigned char c)
                            { return tolower(c); });
+            materializeHeaders();
             headers_[std::move(field)] = std::move(value);
         }
 
@@ -543,6 +609,11 @@ namespace xiaoHttp
             return false;
         }
 
+        void setConnectionPtr(const std::weak_ptr<xiaoNet::TcpConnection> &conn)
+        {
+            connPtr_ = conn;
+        }
+
         const std::weak_ptr<xiaoNet::TcpConnection> &getConnectionPtr()
             const noexcept override
         {
@@ -579,6 +650,9 @@ namespace xiaoHttp
         void streamError(std::exception_ptr ex);
 
         void setStreamReader(RequestStreamReaderPtr reader);
+        void setStreamReader(RequestStreamReaderPtr reader,
+                             size_t initialCredit);
+        void grantStreamCredit(size_t bytes);
         void waitForStreamFinish(std::function<void()> &&cb);
         void quitStreamMode();
 
@@ -612,8 +686,8 @@ namespace xiaoHttp
             if (!flagForParsingContentType_)
             {
                 flagForParsingContentType_ = true;
-                auto &contentTypeString = getHeaderBy("content-type");
-                if (contentTypeString == "")
+                auto contentTypeString = getHeaderView(KnownHeader::ContentType);
+                if (contentTypeString.empty())
                 {
                     contentType_ = CT_NONE;
                 }
@@ -628,7 +702,7 @@ namespace xiaoHttp
                     else
                     {
                         contentType_ =
-                            parseContentType(std::string_view(contentTypeString));
+                            parseContentType(contentTypeString);
                     }
 
                     if (contentType_ == CT_NONE)
@@ -640,6 +714,8 @@ namespace xiaoHttp
 
     private:
         void parseParameters() const;
+        const std::string *findParameter(const std::string &key) const;
+        std::string_view urlEncodedContentView() const;
 
         void parseParametersOnce() const
         {
@@ -653,6 +729,11 @@ namespace xiaoHttp
         void createTmpFile();
         void parseJson() const;
 
+        void feedStreamReader(const char *data, size_t length);
+        void deliverPendingStreamData();
+        void pauseReading();
+        void resumeReading();
+
 #ifdef USE_BROTLI
         StreamDecompressStatus decompressBodyBrotli() noexcept;
 #endif
@@ -671,7 +752,37 @@ namespace xiaoHttp
         bool pathEncode_{true};
         std::string_view matchedPathPattern_{""};
         std::string query_;
-        SafeStringMap<std::string> headers_;
+
+        struct RawHeaderField
+        {
+            uint32_t nameBegin;
+            uint32_t nameLength;
+            uint32_t valueBegin;
+            uint32_t valueLength;
+        };
+
+        static constexpr uint32_t kNoHeaderSlot = UINT32_MAX;
+
+        void materializeHeaders() const;
+        static std::array<uint32_t, kKnownHeaderCount>
+        makeEmptyKnownHeaderSlots()
+        {
+            std::array<uint32_t, kKnownHeaderCount> slots;
+            slots.fill(kNoHeaderSlot);
+            return slots;
+        }
+        void parseCookies(std::string value);
+
+        // The header block of a parsed request, names are lowercased.
+        std::string rawHeaders_;
+        std::vector<RawHeaderField> rawHeaderFields_;
+        // Index in rawHeaderFields_ of the first occurrence of a known
+        // header, kNoHeaderSlot if absent. Not used once the map is
+        // materialized.
+        std::array<uint32_t, kKnownHeaderCount> knownHeaderSlots_{
+            makeEmptyKnownHeaderSlots()};
+        mutable bool headersMaterialized_{false};
+        mutable SafeStringMap<std::string> headers_;
         SafeStringMap<std::string> cookies_;
         mutable SafeStringMap<std::string> parameters_;
         mutable std::shared_ptr<Json::Value> jsonPtr_;
@@ -693,6 +804,13 @@ namespace xiaoHttp
         std::function<void()> streamFinishCb_;
         RequestStreamReaderPtr streamReaderPtr_;
         std::exception_ptr streamExceptionPtr_;
+        // Flow control of the stream, the bytes received beyond the credit
+        // of the reader wait in pendingStreamData_ while the connection
+        // does not read.
+        bool flowControl_{false};
+        bool readingPaused_{false};
+        size_t streamCredit_{0};
+        std::string pendingStreamData_;
         bool startProcessing_{false};
         std::weak_ptr<xiaoNet::TcpConnection> connPtr_;
 
@@ -11,9 +11,11 @@
 #include "HttpRequestParser.h"
 #include <xiaoHttp/utils/Utilities.h>
 #include "HttpRequestImpl.h"
+#include "HttpRequestPool.h"
 #include "HttpResponseImpl.h"
 #include "HttpUtils.h"
 #include "HttpAppFrameworkImpl.h"
+#include <charconv>
 
 using namespace xiaoNet;
 using namespace xiaoHttp;
@@ -23,7 +25,7 @@ static constexpr size_t METHOD_MAX_LEN = 7;     // strlen("OPTIONS")
 static constexpr size_t TRUNK_LEN_MAX_LEN = 16; // OxFFFFFFFF, FFFFFFFF
 
 HttpRequestParser::HttpRequestParser(const xiaoNet::TcpConnectionPtr &connPtr)
-    : status_(HttpRequestParseStatus::kExpectMethod),
+    : status_(HttpRequestParseStatus::kExpectRequestHead),
       loop_(connPtr->getLoop()),
       conn_(connPtr)
 {
@@ -42,100 +44,64 @@ void HttpRequestParser::shutdownConnection(HttpStatusCode code)
     }
 }
 
-bool HttpRequestParser::processRequestLine(const char *begin, const char *end)
+bool HttpRequestParser::processRequestLine(
+    const char *head,
+    const HttpRequestHeadOffsets &offsets)
 {
-    bool succeed = false;
-    const char *start = begin;
-    const char *space = std::find(start, end, ' ');
-    if (space != end)
+    const char *start = head + offsets.targetBegin;
+    const char *space = head + offsets.targetEnd;
+    const char *question =
+        offsets.queryBegin == HttpRequestHeadOffsets::npos
+            ? space
+            : head + offsets.queryBegin - 1;
+    const char *slash = std::find(start, question, '/');
+    if (slash != start && slash + 1 < question && *(slash + 1) == '/')
     {
-        const char *slash = std::find(start, space, '/');
-        if (slash != start && slash + 1 < space && *(slash + 1) == '/')
+        // scheme precedents
+        slash = std::find(slash + 2, question, '/');
+    }
+    if (slash != question)
+    {
+        request_->setPath(slash, question);
+    }
+    else
+    {
+        // An empty abs_path is equivalent to an abs_path of "/"
+        request_->setPath("/");
+    }
+    if (question != space)
+    {
+        request_->setQuery(question + 1, space);
+    }
+    start = space + 1;
+    const char *end = head + offsets.requestLineEnd;
+    bool succeed = end - start == 8 && std::equal(start, end - 1, "HTTP/1.");
+    if (succeed)
+    {
+        if (*(end - 1) == '1')
         {
-            // scheme precedents
-            slash = std::find(slash + 2, space, '/');
+            request_->setVersion(Version::kHttp11);
         }
-        const char *question = std::find(slash, space, '?');
-        if (slash != space)
+        else if (*(end - 1) == '0')
         {
-            request_->setPath(slash, question);
+            request_->setVersion(Version::kHttp10);
         }
         else
         {
-            // An empty abs_path is equivalent to an abs_path of "/"
-            request_->setPath("/");
-        }
-        if (question != space)
-        {
-            request_->setQuery(question + 1, space);
-        }
-        start = space + 1;
-        succeed = end - start == 8 && std::equal(start, end - 1, "HTTP/1.");
-        if (succeed)
-        {
-            if (*(end - 1) == '1')
-            {
-                request_->setVersion(Version::kHttp11);
-            }
-            else if (*(end - 1) == '0')
-            {
-                request_->setVersion(Version::kHttp10);
-            }
-            else
-            {
-                succeed = false;
-            }
+            succeed = false;
         }
     }
     return succeed;
 }
 
-HttpRequestImplPtr HttpRequestParser::makeRequestForPool(HttpRequestImpl *ptr)
-{
-    return std::shared_ptr<HttpRequestImpl>(
-        ptr, [weakPtr = weak_from_this()](HttpRequestImpl *p)
-        {
-            auto thisPtr = weakPtr.lock();
-            if (thisPtr)
-            {
-                if (thisPtr->loop_->isInLoopThread())
-                {
-                    p->reset();
-                    thisPtr->requestsPool_.emplace_back(
-                        thisPtr->makeRequestForPool(p));
-                }
-                else
-                {
-                    auto &loop = thisPtr->loop_;
-                    loop->queueInLoop([thisPtr = std::move(thisPtr), p]()
-                                       {
-                        p->reset();
-                        thisPtr->requestsPool_.emplace_back(
-                            thisPtr->makeRequestForPool(p)); });
-                }
-            }
-            else
-            {
-                delete p;
-            } });
-}
-
 void HttpRequestParser::reset()
 {
     assert(loop_->isInLoopThread());
     currentContentLength_ = 0;
-    status_ = HttpRequestParseStatus::kExpectMethod;
-    if (requestsPool_.empty())
-    {
-        request_ = makeRequestForPool(new HttpRequestImpl(loop_));
-    }
-    else
-    {
-        auto req = std::move(requestsPool_.back());
-        requestsPool_.pop_back();
-        request_ = std::move(req);
-        request_->setCreationDate(xiaoLog::Date::now());
-    }
+    status_ = HttpRequestParseStatus::kExpectRequestHead;
+    headOffsets_.reset();
+    request_ = HttpRequestPool::acquire(loop_);
+    request_->setConnectionPtr(conn_);
 }
 
 int HttpRequestParser::parseRequest(MsgBuffer *buf)
@@ -144,94 +110,73 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
     {
         switch (status_)
         {
-        case HttpRequestParseStatus::kExpectMethod:
+        case HttpRequestParseStatus::kExpectRequestHead:
         {
-            auto *space = std::find(buf->peek(),
-                                    (const char *)buf->beginWrite(),
-                                    ' ');
-            if (space == buf->beginWrite())
+            // The request line and all header fields are tokenized in one
+            // pass, the head is only consumed once it is complete.
+            const char *head = buf->peek();
+            auto scanResult =
+                HttpHeaderScanner::scanRequestHead(head,
+                                                   buf->beginWrite(),
+                                                   headOffsets_);
+            if (scanResult == HttpHeadScanResult::kIncomplete)
             {
-                if (buf->readableBytes() > METHOD_MAX_LEN)
+                if (headOffsets_.methodEnd == HttpRequestHeadOffsets::npos &&
+                    buf->readableBytes() > METHOD_MAX_LEN)
                 {
                     buf->retrieveAll();
+                    headOffsets_.reset();
                     shutdownConnection(k400BadRequest);
                     return -1;
                 }
-                return 0;
-            }
-            if (!request_->setMethod(buf->peek(), space))
-            {
-                buf->retrieveAll();
-                shutdownConnection(k405MethodNotAllowed);
-                return -1;
-            }
-            status_ = HttpRequestParseStatus::kExpectRequestLine;
-            buf->retrieveUntil(space + 1);
-            continue;
-        }
-        case HttpRequestParseStatus::kExpectRequestLine:
-        {
-            const char *crlf = buf->findCRLF();
-            if (!crlf)
-            {
                 if (buf->readableBytes() >= 64 * 1024)
                 {
+                    /// The limit for every request header is 64K bytes;
+                    /// TODO: Make this configurable?
                     buf->retrieveAll();
-                    shutdownConnection(k414RequestURITooLarge);
+                    shutdownConnection(headOffsets_.requestLineEnd ==
+                                               HttpRequestHeadOffsets::npos
+                                           ? k414RequestURITooLarge
+                                           : k400BadRequest);
+                    headOffsets_.reset();
                     return -1;
                 }
                 return 0;
             }
-            if (!processRequestLine(buf->peek(), crlf))
+            if (scanResult == HttpHeadScanResult::kMalformed)
             {
                 buf->retrieveAll();
+                headOffsets_.reset();
                 shutdownConnection(k400BadRequest);
                 return -1;
             }
-            buf->retrieveUntil(crlf + CRLF_LEN);
-            status_ = HttpRequestParseStatus::kExpectHeaders;
-            continue;
-        }
-        case HttpRequestParseStatus::kExpectHeaders:
-        {
-            const char *crlf = buf->findCRLF();
-            if (!crlf)
+            if (!request_->setMethod(head, head + headOffsets_.methodEnd))
             {
-                if (buf->readableBytes() >= 64 * 1024)
-                {
-                    /// The limit for every request header is 64K bytes;
-                    /// TODO: Make this configurable?
-                    buf->retrieveAll();
-                    shutdownConnection(k400BadRequest);
-                    return -1;
-                }
-                return 0;
+                buf->retrieveAll();
+                shutdownConnection(k405MethodNotAllowed);
+                return -1;
             }
-
-            const char *colon = std::find(buf->peek(), crlf, ':');
-            // found colon
-            if (colon != crlf)
+            if (!processRequestLine(head, headOffsets_))
             {
-                request_->addHeader(buf->peek(), colon, crlf);
-                buf->retrieveUntil(crlf + CRLF_LEN);
-                continue;
+                buf->retrieveAll();
+                shutdownConnection(k400BadRequest);
+                return -1;
             }
-            buf->retrieveUntil(crlf + CRLF_LEN);
+            request_->setRawHeaders(head, headOffsets_);
+            buf->retrieve(headOffsets_.headEnd);
             // end of headers
 
             // We might want a kProcessHeaders status for code readability
             // and maintainability.
 
             // process header information
-            auto &len = request_->getHeaderBy("content-length");
+            auto len = request_->getHeaderView(KnownHeader::ContentLength);
             if (!len.empty())
             {
-                try
-                {
-                    currentContentLength_ =
-                        static_cast<size_t>(std::stoull(len));
-                }
-                catch (...)
+                auto [ptr, ec] = std::from_chars(len.data(),
+                                                 len.data() + len.size(),
+                                                 currentContentLength_);
+                if (ec != std::errc() || ptr != len.data() + len.size())
                 {
                     buf->retrieveAll();
                     shutdownConnection(k400BadRequest);
@@ -251,8 +196,7 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
             }
             else
             {
-                const std::string &encode =
-                    request_->getHeaderBy("transfer-encoding");
+                auto encode = request_->getHeaderView(KnownHeader::TransferEncoding);
                 if (encode.empty())
                 {
                     // no content-length and no transfer-encoding,
@@ -353,7 +297,8 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
         }
         case HttpRequestParseStatus::kExpectChunkLen:
         {
-            const char *crlf = buf->findCRLF();
+            const char *crlf =
+                HttpHeaderScanner::findCRLF(buf->peek(), buf->beginWrite());
             if (!crlf)
             {
                 if (buf->readableBytes() > TRUNK_LEN_MAX_LEN + CRLF_LEN)
@@ -18,6 +18,7 @@
 #include <deque>
 
 #include "impl_forwards.h"
+#include "HttpHeaderScanner.h"
 
 namespace xiaoHttp
 {
@@ -27,9 +28,7 @@ namespace xiaoHttp
     public:
         enum class HttpRequestParseStatus
         {
-            kExpectMethod,
-            kExpectRequestLine,
-            kExpectHeaders,
+            kExpectRequestHead,
             kExpectBody,
             kExpectChunkLen,
             kExpectChunkBody,
@@ -73,6 +72,19 @@ namespace xiaoHttp
             websockConnPtr_ = conn;
         }
 
+        // The async stream response being sent, if any
+        const std::weak_ptr<internal::ResponseStreamFlow> &
+        responseStreamFlow() const
+        {
+            return responseStreamFlow_;
+        }
+
+        void setResponseStreamFlow(
+            const std::shared_ptr<internal::ResponseStreamFlow> &flow)
+        {
+            responseStreamFlow_ = flow;
+        }
+
         // to support request pipelining
         void pushRequestToPipelining(const HttpRequestPtr &, bool isHeadMethod);
         bool pushResponseToPipelining(const HttpRequestPtr &, HttpResponsePtr);
@@ -132,14 +144,15 @@ namespace xiaoHttp
         }
 
     private:
-        HttpRequestImplPtr makeRequestForPool(HttpRequestImpl *p);
         void shutdownConnection(HttpStatusCode code);
-        bool processRequestLine(const char *begin, const char *end);
+        bool processRequestLine(const char *head,
+                                const HttpRequestHeadOffsets &offsets);
         HttpRequestParseStatus status_;
         xiaoNet::EventLoop *loop_;
         HttpRequestImplPtr request_;
         bool firstRequest_{true};
         WebSocketConnectionImplPtr websockConnPtr_;
+        std::weak_ptr<internal::ResponseStreamFlow> responseStreamFlow_;
         std::deque<std::pair<HttpRequestPtr, std::pair<HttpResponsePtr, bool>>>
             requestPipelining_;
         size_t requestsCounter_{0};
@@ -149,8 +162,8 @@ namespace xiaoHttp
         std::unique_ptr<std::vector<std::pair<HttpResponsePtr, bool>>>
             responseBuffer_;
         std::unique_ptr<std::vector<HttpRequestImplPtr>> requestBuffer_;
-        std::vector<HttpRequestImplPtr> requestsPool_;
         size_t currentChunkLength_{0};
         size_t currentContentLength_{0};
+        HttpRequestHeadOffsets headOffsets_;
     };
 }
\ No newline at end of file
@@ -0,0 +1,185 @@
+/**
+ * @file HttpRequestPool.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-19
+ *
+ *
+ */
+
+#include "HttpRequestPool.h"
+#include "HttpRequestImpl.h"
+#include <atomic>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+
+using namespace xiaoHttp;
+
+// The memory of the control blocks of one IO thread. It is only used by
+// that thread without a lock. The last reference to a request may still
+// be dropped in another thread, such a block is handed back through a
+// list that the owner empties on its next allocation.
+class xiaoHttp::ControlBlockPool
+{
+public:
+    void *allocate(size_t bytes, size_t alignment)
+    {
+        assert(std::this_thread::get_id() == owner_);
+        if (hasRemoteFrees_.load(std::memory_order_acquire))
+        {
+            std::vector<Block> blocks;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                blocks.swap(remoteFrees_);
+                hasRemoteFrees_.store(false, std::memory_order_relaxed);
+            }
+            for (auto &block : blocks)
+                resource_.deallocate(block.ptr,
+                                     block.bytes,
+                                     block.alignment);
+        }
+        return resource_.allocate(bytes, alignment);
+    }
+
+    void deallocate(void *ptr, size_t bytes, size_t alignment)
+    {
+        if (std::this_thread::get_id() == owner_)
+        {
+            resource_.deallocate(ptr, bytes, alignment);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        remoteFrees_.push_back({ptr, bytes, alignment});
+        hasRemoteFrees_.store(true, std::memory_order_release);
+    }
+
+private:
+    struct Block
+    {
+        void *ptr;
+        size_t bytes;
+        size_t alignment;
+    };
+
+    const std::thread::id owner_{std::this_thread::get_id()};
+    std::pmr::unsynchronized_pool_resource resource_;
+    std::atomic<bool> hasRemoteFrees_{false};
+    std::mutex mutex_;
+    std::vector<Block> remoteFrees_;
+};
+
+namespace
+{
+    // Every control block keeps its pool alive, so a block that outlives
+    // the IO thread is still freed into valid memory.
+    template <typename T>
+    struct ControlBlockAllocator
+    {
+        using value_type = T;
+
+        explicit ControlBlockAllocator(std::shared_ptr<ControlBlockPool> pool)
+            : pool_(std::move(pool))
+        {
+        }
+
+        template <typename U>
+        ControlBlockAllocator(const ControlBlockAllocator<U> &other)
+            : pool_(other.pool_)
+        {
+        }
+
+        T *allocate(size_t n)
+        {
+            return static_cast<T *>(
+                pool_->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T *p, size_t n)
+        {
+            pool_->deallocate(p, n * sizeof(T), alignof(T));
+        }
+
+        template <typename U>
+        bool operator==(const ControlBlockAllocator<U> &other) const
+        {
+            return pool_ == other.pool_;
+        }
+
+        template <typename U>
+        bool operator!=(const ControlBlockAllocator<U> &other) const
+        {
+            return pool_ != other.pool_;
+        }
+
+        std::shared_ptr<ControlBlockPool> pool_;
+    };
+}
+
+HttpRequestPool::HttpRequestPool()
+    : controlBlocks_(std::make_shared<ControlBlockPool>())
+{
+}
+
+const std::shared_ptr<HttpRequestPool> &HttpRequestPool::instance()
+{
+    thread_local std::shared_ptr<HttpRequestPool> pool =
+        std::make_shared<HttpRequestPool>();
+    return pool;
+}
+
+HttpRequestPool::~HttpRequestPool()
+{
+    for (auto req : idle_)
+        delete req;
+}
+
+HttpRequestImplPtr HttpRequestPool::acquire(xiaoNet::EventLoop *loop)
+{
+    assert(loop->isInLoopThread());
+    auto &pool = instance();
+    if (pool->idle_.empty())
+        return pool->makeShared(new HttpRequestImpl(loop));
+    auto req = pool->idle_.back();
+    pool->idle_.pop_back();
+    // Every connection of the thread runs in the same loop
+    assert(req->getLoop() == loop);
+    req->setCreationDate(xiaoLog::Date::now());
+    return pool->makeShared(req);
+}
+
+HttpRequestImplPtr HttpRequestPool::makeShared(HttpRequestImpl *req)
+{
+    return HttpRequestImplPtr(
+        req,
+        [weakPtr = weak_from_this()](HttpRequestImpl *p)
+        {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+            {
+                // The IO thread is gone
+                delete p;
+                return;
+            }
+            if (p->getLoop()->isInLoopThread())
+            {
+                thisPtr->recycle(p);
+                return;
+            }
+            p->getLoop()->queueInLoop(
+                [thisPtr = std::move(thisPtr), p]() { thisPtr->recycle(p); });
+        },
+        ControlBlockAllocator<HttpRequestImpl>(controlBlocks_));
+}
+
+void HttpRequestPool::recycle(HttpRequestImpl *req)
+{
+    if (idle_.size() >= kMaxIdleRequests)
+    {
+        delete req;
+        return;
+    }
+    req->reset();
+    idle_.push_back(req);
+}
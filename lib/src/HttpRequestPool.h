@@ -0,0 +1,54 @@
+/**
+ * @file HttpRequestPool.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-19
+ *
+ *
+ */
+
+#pragma once
+
+#include "impl_forwards.h"
+#include <xiaoNet/net/EventLoop.h>
+#include <memory>
+#include <vector>
+
+namespace xiaoHttp
+{
+    class ControlBlockPool;
+
+    /**
+     * @brief The requests of an IO thread that are reused once their
+     * handling is over, shared by all the connections of the thread.
+     *
+     * A released request is reset in its IO thread and handed out again,
+     * the capacity of its strings and containers is kept. The control
+     * blocks of the handed out shared pointers come from a pool of the
+     * thread instead of the heap, so a keep-alive request does not allocate
+     * at all once the pool is warm.
+     */
+    class HttpRequestPool : public std::enable_shared_from_this<HttpRequestPool>
+    {
+    public:
+        HttpRequestPool();
+        ~HttpRequestPool();
+
+        /// Take a request of the pool of the calling IO thread, which must
+        /// be the thread of @p loop.
+        static HttpRequestImplPtr acquire(xiaoNet::EventLoop *loop);
+
+        /// Requests kept per IO thread, the others are freed.
+        static constexpr size_t kMaxIdleRequests = 256;
+
+    private:
+        static const std::shared_ptr<HttpRequestPool> &instance();
+
+        HttpRequestImplPtr makeShared(HttpRequestImpl *req);
+        void recycle(HttpRequestImpl *req);
+
+        std::vector<HttpRequestImpl *> idle_;
+        std::shared_ptr<ControlBlockPool> controlBlocks_;
+    };
+}
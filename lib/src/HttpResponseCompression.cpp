@@ -0,0 +1,308 @@
+/**
+ * @file HttpResponseCompression.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-13
+ *
+ *
+ */
+
+#include "HttpResponseCompression.h"
+#include "HttpCompressionPolicy.h"
+#include "HttpResponseImpl.h"
+#include <xiaoLog/Logger.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+using namespace xiaoHttp;
+
+static std::string_view trim(std::string_view sv)
+{
+    while (!sv.empty() && (sv.front() == ' ' || sv.front() == '\t'))
+        sv.remove_prefix(1);
+    while (!sv.empty() && (sv.back() == ' ' || sv.back() == '\t'))
+        sv.remove_suffix(1);
+    return sv;
+}
+
+static bool equalsIgnoreCase(std::string_view a, std::string_view b)
+{
+    return a.length() == b.length() &&
+           std::equal(a.begin(),
+                      a.end(),
+                      b.begin(),
+                      [](unsigned char x, unsigned char y)
+                      { return tolower(x) == tolower(y); });
+}
+
+// qvalue = ( "0" [ "." 0*3DIGIT ] ) / ( "1" [ "." 0*3("0") ] ), in
+// thousandths, -1 if it is malformed
+static int parseQValue(std::string_view sv)
+{
+    if (sv.empty() || (sv[0] != '0' && sv[0] != '1'))
+        return -1;
+    int value = (sv[0] - '0') * 1000;
+    if (sv.size() == 1)
+        return value;
+    if (sv[1] != '.' || sv.size() > 5)
+        return -1;
+    int scale = 100;
+    for (size_t i = 2; i < sv.size(); ++i, scale /= 10)
+    {
+        if (sv[i] < '0' || sv[i] > '9')
+            return -1;
+        value += (sv[i] - '0') * scale;
+    }
+    return value > 1000 ? -1 : value;
+}
+
+int HttpResponseCompression::qValue(std::string_view acceptEncoding,
+                                    ContentCoding coding)
+{
+    auto name = HttpCompressor::name(coding);
+    int starValue = 0;
+    while (!acceptEncoding.empty())
+    {
+        auto comma = acceptEncoding.find(',');
+        auto element = acceptEncoding.substr(0, comma);
+        acceptEncoding.remove_prefix(comma == std::string_view::npos
+                                         ? acceptEncoding.size()
+                                         : comma + 1);
+        auto semicolon = element.find(';');
+        auto token = trim(element.substr(0, semicolon));
+        int value = 1000;
+        while (semicolon != std::string_view::npos)
+        {
+            element.remove_prefix(semicolon + 1);
+            semicolon = element.find(';');
+            auto param = trim(element.substr(0, semicolon));
+            if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') &&
+                param[1] == '=')
+                value = parseQValue(param.substr(2));
+        }
+        // A malformed element is ignored
+        if (value < 0)
+            continue;
+        if (equalsIgnoreCase(token, name) ||
+            (coding == ContentCoding::kGzip &&
+             equalsIgnoreCase(token, "x-gzip")))
+            return value;
+        if (token == "*")
+            starValue = value;
+    }
+    return starValue;
+}
+
+bool HttpResponseCompression::selectCoding(std::string_view acceptEncoding,
+                                           const EnabledCodings &enabled,
+                                           ContentCoding &coding)
+{
+    if (acceptEncoding.empty())
+        return false;
+    // In the order of preference, a later coding must be accepted with a
+    // higher q-value to be chosen
+    const std::pair<ContentCoding, bool> candidates[] = {
+        {ContentCoding::kZstd, enabled.zstd},
+        {ContentCoding::kBrotli, enabled.brotli},
+        {ContentCoding::kGzip, enabled.gzip}};
+    int best = 0;
+    for (auto &[candidate, isEnabled] : candidates)
+    {
+        if (!isEnabled || !HttpCompressor::isSupported(candidate))
+            continue;
+        auto value = qValue(acceptEncoding, candidate);
+        if (value > best)
+        {
+            best = value;
+            coding = candidate;
+        }
+    }
+    return best > 0;
+}
+
+// A stream without a content length is sent chunked or until the connection
+// is closed, so it can be compressed while it is sent.
+static bool streamShouldBeCompressed(HttpResponseImpl *respImplPtr)
+{
+    return (respImplPtr->streamCallback() ||
+            respImplPtr->asyncStreamCallback()) &&
+           respImplPtr->getHeaderBy("content-encoding").empty() &&
+           respImplPtr->getHeaderBy("content-length").empty() &&
+           respImplPtr->contentLengthIsAllowed();
+}
+
+// Compress the pieces produced by a stream callback as they are read. Every
+// piece is flushed so the client is not kept waiting for buffered data.
+static void compressStream(HttpResponseImpl *respImplPtr,
+                           ContentCoding coding,
+                           int level)
+{
+    if (respImplPtr->asyncStreamCallback())
+    {
+        auto callback = respImplPtr->asyncStreamCallback();
+        respImplPtr->setAsyncStreamCallback(
+            [callback, coding, level](ResponseStreamPtr stream)
+            {
+                std::shared_ptr<StreamCompressor> compressor =
+                    HttpCompressor::acquire(coding, level);
+                stream->setEncoder(
+                    [compressor](const char *data,
+                                 size_t len,
+                                 bool finish,
+                                 std::string &out)
+                    {
+                        return compressor->compress(
+                            data,
+                            len,
+                            finish ? StreamCompressor::Flush::kFinish
+                                   : StreamCompressor::Flush::kSync,
+                            out);
+                    });
+                callback(std::move(stream));
+            },
+            respImplPtr->asyncStreamKickoffDisabled());
+        return;
+    }
+
+    struct StreamState
+    {
+        std::function<std::size_t(char *, std::size_t)> callback;
+        StreamCompressorPtr compressor;
+        std::string input;
+        std::string output;
+        size_t outputPos{0};
+        bool finished{false};
+    };
+    auto state = std::make_shared<StreamState>();
+    state->callback = respImplPtr->streamCallback();
+    state->compressor = HttpCompressor::acquire(coding, level);
+    respImplPtr->setStreamCallback(
+        [state](char *buffer, std::size_t len) -> std::size_t
+        {
+            if (buffer == nullptr)
+            {
+                state->compressor.reset();
+                return state->callback(nullptr, 0);
+            }
+            while (state->outputPos == state->output.size())
+            {
+                if (state->finished)
+                    return 0;
+                state->output.clear();
+                state->outputPos = 0;
+                state->input.resize(len);
+                auto n = state->callback(state->input.data(), len);
+                if (n == 0)
+                    state->finished = true;
+                if (!state->compressor->compress(
+                        state->input.data(),
+                        n,
+                        n == 0 ? StreamCompressor::Flush::kFinish
+                               : StreamCompressor::Flush::kSync,
+                        state->output))
+                {
+                    LOG_ERROR << "Failed to compress the response stream";
+                    state->finished = true;
+                    state->output.clear();
+                    return 0;
+                }
+            }
+            auto n = std::min(len, state->output.size() - state->outputPos);
+            memcpy(buffer, state->output.data() + state->outputPos, n);
+            state->outputPos += n;
+            return n;
+        });
+}
+
+void HttpResponseCompression::addVaryAcceptEncoding(
+    HttpResponseImpl *respImplPtr)
+{
+    auto vary = respImplPtr->getHeaderBy("vary");
+    if (vary.empty())
+    {
+        respImplPtr->addHeader("vary", "Accept-Encoding");
+        return;
+    }
+    std::transform(vary.begin(), vary.end(), vary.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    if (vary == "*" || vary.find("accept-encoding") != std::string::npos)
+        return;
+    respImplPtr->addHeader("vary",
+                           respImplPtr->getHeaderBy("vary") +
+                               ", Accept-Encoding");
+}
+
+HttpResponsePtr HttpResponseCompression::compress(
+    std::string_view acceptEncoding,
+    const HttpResponsePtr &response,
+    const CompressionPolicy &policy,
+    const EnabledCodings &enabled)
+{
+    auto respImplPtr = static_cast<HttpResponseImpl *>(response.get());
+    auto isStream = streamShouldBeCompressed(respImplPtr);
+    if (!isStream && !respImplPtr->shouldBeCompressed())
+        return response;
+    if (!HttpCompressionPolicy::isCompressible(
+            policy,
+            respImplPtr->contentType(),
+            respImplPtr->contentTypeString(),
+            isStream ? HttpCompressionPolicy::unknownLength
+                     : respImplPtr->getBody().length()))
+        return response;
+    ContentCoding coding;
+    if (!selectCoding(acceptEncoding, enabled, coding))
+        return response;
+    std::string codingName(HttpCompressor::name(coding));
+
+    // A cached or frozen response keeps its compressed copies, so each one
+    // is only compressed once.
+    auto variants = respImplPtr->compressedVariants();
+    auto slot = static_cast<size_t>(coding);
+    if (variants)
+    {
+        std::lock_guard<std::mutex> lock(variants->mutex);
+        if (variants->responses[slot])
+            return variants->responses[slot];
+    }
+
+    // Under load the level is lowered, or the response is sent as it is
+    auto level = HttpCompressionPolicy::level(policy, coding);
+    if (level < 0)
+        return response;
+    if (isStream)
+    {
+        compressStream(respImplPtr, coding, level);
+        respImplPtr->addHeader("content-encoding", std::move(codingName));
+        addVaryAcceptEncoding(respImplPtr);
+        return response;
+    }
+
+    auto body = response->getBody();
+    auto compressed =
+        HttpCompressor::compress(coding, level, body.data(), body.length());
+    if (compressed.empty())
+    {
+        LOG_ERROR << codingName << " got 0 length result";
+        return response;
+    }
+    if (!variants)
+    {
+        response->setBody(std::move(compressed));
+        response->addHeader("content-encoding", std::move(codingName));
+        addVaryAcceptEncoding(respImplPtr);
+        return response;
+    }
+    // The response is shared, compress a copy of it
+    auto variant = std::make_shared<HttpResponseImpl>(*respImplPtr);
+    variant->detachFromCache();
+    variant->setBody(std::move(compressed));
+    variant->addHeader("content-encoding", std::move(codingName));
+    addVaryAcceptEncoding(variant.get());
+    variant->freeze();
+    std::lock_guard<std::mutex> lock(variants->mutex);
+    variants->responses[slot] = variant;
+    return variant;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file HttpResponseCompression.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-13
+ *
+ *
+ */
+
+#pragma once
+
+#include "HttpCompressor.h"
+#include <xiaoHttp/CompressionPolicy.h>
+#include <xiaoHttp/HttpResponse.h>
+#include <string_view>
+
+namespace xiaoHttp
+{
+    class HttpResponseImpl;
+
+    /// The codings switched on in the app.
+    struct EnabledCodings
+    {
+        bool gzip{false};
+        bool brotli{false};
+        bool zstd{false};
+    };
+
+    /**
+     * @brief Compress a response for the Accept-Encoding of its request.
+     *
+     * It is called on the send path, before the response is rendered. A
+     * cached or frozen response is never changed, its compressed copies are
+     * kept with it and reused by the next requests.
+     */
+    class HttpResponseCompression
+    {
+    public:
+        /**
+         * @brief Return the q-value of a coding in an Accept-Encoding list,
+         * from 0 to 1000.
+         *
+         * A coding that is not listed gets the value of "*", or 0 if there
+         * is none. 0 means the coding is refused.
+         */
+        static int qValue(std::string_view acceptEncoding,
+                          ContentCoding coding);
+
+        /**
+         * @brief Pick the coding of a response from an Accept-Encoding list.
+         *
+         * The highest q-value wins, a tie goes to the better ratio: zstd,
+         * br, then gzip.
+         * @return false if none of the enabled codings is accepted.
+         */
+        static bool selectCoding(std::string_view acceptEncoding,
+                                 const EnabledCodings &enabled,
+                                 ContentCoding &coding);
+
+        /**
+         * @brief Return the response to send, compressed if the policy and
+         * the request allow it, or @p response as it is.
+         */
+        static HttpResponsePtr compress(std::string_view acceptEncoding,
+                                        const HttpResponsePtr &response,
+                                        const CompressionPolicy &policy,
+                                        const EnabledCodings &enabled);
+
+        /**
+         * @brief Add Accept-Encoding to the Vary header.
+         *
+         * The body depends on that header of the request, a shared cache
+         * must not give a compressed one to a client that did not ask.
+         */
+        static void addVaryAcceptEncoding(HttpResponseImpl *respImplPtr);
+    };
+}
@@ -11,6 +11,7 @@
 #include "HttpResponseImpl.h"
 #include "AOPAdvice.h"
 #include "HttpAppFrameworkImpl.h"
+#include "HttpDate.h"
 #include "HttpUtils.h"
 #include <xiaoHttp/HttpViewData.h>
 
@@ -20,9 +21,6 @@ using namespace xiaoLog;
 
 namespace xiaoHttp
 {
-    // "Fri, 23 Aug 2019 12:58:03 GMT" length = 29
-    static const size_t httpFullDateStringLength = 29;
-
     static inline HttpResponsePtr genHttpResponse(const std::string &viewName,
                                                   const HttpViewData &data,
                                                   const HttpRequestPtr &req)
@@ -53,7 +51,7 @@ HttpResponsePtr HttpResponse::newHttpResponse(HttpStatusCode code,
     return res;
 }
 
-HttpResponsePtr HttpRESPONSE::newHttpJsonResponse(const Json::Value &data)
+HttpResponsePtr HttpResponse::newHttpJsonResponse(const Json::Value &data)
 {
     auto res = std::make_shared<HttpResponseImpl>(k200OK, CT_APPLICATION_JSON);
     res->setJsonObject(data);
@@ -198,13 +196,54 @@ void HttpResponseImpl::addHeader(const char *start,
 
 void HttpResponseImpl::renderToBuffer(xiaoNet::MsgBuffer &buffer)
 {
-    if (expriedTime_ >= 0)
+    renderHeaderToBuffer(buffer);
+    if (bodyPtr_ && contentLengthIsAllowed())
+        buffer.append(bodyPtr_->data(), bodyPtr_->length());
+}
+
+void HttpResponseImpl::freeze()
+{
+    if (frozen_)
+        return;
+    auto httpString = std::make_shared<xiaoNet::MsgBuffer>(256);
+    // This also serializes a json body
+    datePos_ = renderHeader(*httpString);
+    httpString_ = httpString;
+    frozen_ = true;
+    resetCompressedVariants();
+}
+
+void HttpResponseImpl::renderHeaderToBuffer(xiaoNet::MsgBuffer &buffer)
+{
+    if (expriedTime_ < 0 && !frozen_)
     {
-        auto strPtr = renderToBuffer();
-        buffer.append(strPtr->peek(), strPtr->readableBytes());
+        renderHeader(buffer);
         return;
     }
+    // The header of a cached response is rendered once, only the date is
+    // replaced while it is copied out.
+    if (!httpString_)
+    {
+        auto httpString = std::make_shared<xiaoNet::MsgBuffer>(256);
+        datePos_ = renderHeader(*httpString);
+        httpString_ = httpString;
+    }
+    if (datePos_ == std::string::npos)
+    {
+        buffer.append(*httpString_);
+        return;
+    }
+    auto date = currentHttpDate();
+    auto afterDate = datePos_ + httpFullDateStringLength;
+    buffer.append(httpString_->peek(), datePos_);
+    buffer.append(date.data(), date.length());
+    buffer.append(httpString_->peek() + afterDate,
+                  httpString_->readableBytes() - afterDate);
+}
 
+size_t HttpResponseImpl::renderHeader(xiaoNet::MsgBuffer &buffer)
+{
+    auto begin = buffer.readableBytes();
     if (!fullHeaderString_)
     {
         makeHeaderString(buffer);
@@ -224,101 +263,27 @@ void HttpResponseImpl::renderToBuffer(xiaoNet::MsgBuffer &buffer)
     }
 
     // output Date header
+    size_t datePos = std::string::npos;
     if (!passThrough_ &&
-        drogon::HttpAppFrameworkImpl::instance().sendDateHeader())
+        xiaoHttp::HttpAppFrameworkImpl::instance().sendDateHeader())
     {
         buffer.append("date: ");
-        buffer.append(utils::getHttpFullDateStr(xiaoLog::Date::date()));
+        datePos = buffer.readableBytes() - begin;
+        auto date = currentHttpDate();
+        buffer.append(date.data(), date.length());
         buffer.append("\r\n\r\n");
     }
     else
     {
         buffer.append("\r\n");
     }
-    if (bodyPtr_ && contentLengthIsAllowed())
-        buffer.append(bodyPtr_->data(), bodyPtr_->length());
+    return datePos;
 }
 
 std::shared_ptr<xiaoNet::MsgBuffer> HttpResponseImpl::renderToBuffer()
 {
-    if (expriedTime_ >= 0)
-    {
-        if (!passThrough_ &&
-            xiaoHttp::HttpAppFrameworkImpl::instance().sendDateHeader())
-        {
-            if (datePos_ != static_cast<size_t>(-1))
-            {
-                auto now = xiaoLog::Date::now();
-                bool isDateChanged =
-                    ((now.microSecondsSinceEpoch() / MICRO_SECONDS_PRE_SEC) !=
-                     httpStringDate_);
-                assert(httpString_);
-                if (isDateChanged)
-                {
-                    httpStringDate_ =
-                        now.microSecondsSinceEpoch() / MICRO_SECONDS_PRE_SEC;
-                    auto newDate = utils::getHttpFullDate(now);
-
-                    httpString_ =
-                        std::make_shared<xiaoNet::MsgBuffer>(*httpString_);
-                    memcpy((void *)&(*httpString_)[datePos_],
-                           newDate,
-                           httpFullDateStringLength);
-                    return httpString_;
-                }
-
-                return httpString_;
-            }
-        }
-        else
-        {
-            if (httpString_)
-                return httpString_;
-        }
-    }
     auto httpString = std::make_shared<xiaoNet::MsgBuffer>(256);
-    if (!fullHeaderString_)
-    {
-        makeHeaderString(*httpString);
-    }
-    else
-    {
-        httpString->append(*fullHeaderString_);
-    }
-
-    // output cookies
-    if (!cookies_.empty())
-    {
-        for (auto it = cookies_.begin(); it != cookies_.end(); ++it)
-        {
-            httpString->append(it->second.cookieString());
-        }
-    }
-
-    // output Date header
-    if (!passThrough_ &&
-        xiaoHttp::HttpAppFrameworkImpl::instance().sendDateHeader())
-    {
-        httpString->append("date: ");
-        auto datePos = httpString->readableBytes();
-        httpString->append(utils::getHttpFullDateStr(xiaoLog::Date::date()));
-        httpString->append("\r\n\r\n");
-        datePos_ = datePos;
-    }
-    else
-    {
-        httpString->append("\r\n");
-    }
-
-    LOG_TRACE << "response(no body):"
-              << std::string_view{httpString->peek(),
-                                  httpString->readableBytes()};
-    if (bodyPtr_)
-        httpString->append(bodyPtr_->data(), bodyPtr_->length());
-    if (expriedTime_ >= 0)
-    {
-        httpString_ = httpString;
-    }
+    renderToBuffer(*httpString);
     return httpString;
 }
 
@@ -326,38 +291,7 @@ std::shared_ptr<xiaoNet::MsgBuffer> HttpResponseImpl::
     renderHeaderForHeadMethod()
 {
     auto httpString = std::make_shared<xiaoNet::MsgBuffer>(256);
-    if (!fullHeaderString_)
-    {
-        makeHeaderString(*httpString);
-    }
-    else
-    {
-        httpString->append(*fullHeaderString_);
-    }
-
-    // output cookies
-    if (!cookies_.empty())
-    {
-        for (auto it = cookies_.begin(); it != cookies_.end(); ++it)
-        {
-            httpString->append(it->second.cookieString());
-        }
-    }
-
-    // output Date header
-    if (!passThrough_ &&
-        xiaoHttp::HttpAppFrameworkImpl::instance().sendDateHeader())
-    {
-        httpString->append("date: ");
-        httpString->append(utils::getHttpFullDate(xiaoLog::Date::date()),
-                           httpFullDateStringLength);
-        httpString->append("\r\n\r\n");
-    }
-    else
-    {
-        httpString->append("\r\n");
-    }
-
+    renderHeaderToBuffer(*httpString);
     return httpString;
 }
 
@@ -369,6 +303,8 @@ void HttpResponseImpl::clear()
     fullHeaderString_.reset();
     jsonParsingErrorPtr_.reset();
     sendfileName_.clear();
+    sendfileParts_.clear();
+    sendfileTrailer_.clear();
     if (streamCallback_)
     {
         LOG_TRACE << "Cleanup HttpResponse stream callback";
@@ -385,6 +321,9 @@ void HttpResponseImpl::clear()
     bodyPtr_.reset();
     jsonPtr_.reset();
     expriedTime_ = -1;
+    frozen_ = false;
+    compressedVariants_.reset();
+    httpString_.reset();
     datePos_ = std::string::npos;
     flagForParsingContentType_ = false;
     flagForParsingJson_ = false;
@@ -392,22 +331,15 @@ void HttpResponseImpl::clear()
 
 void HttpResponseImpl::parseJson() const
 {
-    static std::once_flag once;
-    static Json::CharReaderBuilder builder;
-    std::call_once(once, []()
-                   {
-        builder["collectComments"] = false;
-        builder["stackLimit"] =
-            static_cast<Json::UInt>(drogon::app().getJsonParserStackLimit()); });
-    JSONCPP_STRING errs;
-    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    std::string errs;
     if (bodyPtr_)
     {
         jsonPtr_ = std::make_shared<Json::Value>();
-        if (!reader->parse(bodyPtr_->data(),
-                           bodyPtr_->data() + bodyPtr_->length(),
-                           jsonPtr_.get(),
-                           &errs))
+        auto &backend = HttpAppFrameworkImpl::instance().getJsonBackend();
+        if (!backend->parse(bodyPtr_->data(),
+                            bodyPtr_->data() + bodyPtr_->length(),
+                            *jsonPtr_,
+                            errs))
         {
             LOG_ERROR << errs;
             LOG_ERROR << "body: " << bodyPtr_->getString();
@@ -431,8 +363,6 @@ void HttpResponseImpl::parseJson() const
 bool HttpResponseImpl::shouldBeCompressed() const
 {
     if (streamCallback_ || asyncStreamCallback_ || !sendfileName_.empty() ||
-        contentType() >= CT_APPLICATION_OCTET_STREAM ||
-        getBody().length() < 1024 ||
         !(getHeaderBy("content-encoding").empty()) || !contentLengthIsAllowed())
     {
         return false;
@@ -466,12 +396,17 @@ void HttpResponseImpl::swap(HttpResponseImpl &that) noexcept
     swap(flagForParsingContentType_, that.flagForParsingContentType_);
     swap(flagForParsingJson_, that.flagForParsingJson_);
     swap(sendfileName_, that.sendfileName_);
+    swap(sendfileRange_, that.sendfileRange_);
+    swap(sendfileParts_, that.sendfileParts_);
+    swap(sendfileTrailer_, that.sendfileTrailer_);
     swap(streamCallback_, that.streamCallback_);
     swap(asyncStreamCallback_, that.asyncStreamCallback_);
     jsonPtr_.swap(that.jsonPtr_);
     fullHeaderString_.swap(that.fullHeaderString_);
     httpString_.swap(that.httpString_);
     swap(datePos_, that.datePos_);
+    swap(frozen_, that.frozen_);
+    compressedVariants_.swap(that.compressedVariants_);
     swap(jsonParsingErrorPtr_, that.jsonParsingErrorPtr_);
 }
 
@@ -482,24 +417,11 @@ void HttpResponseImpl::generateBodyFromJson() const
         return;
     }
     flagForSerializingJson_ = true;
-    static std::once_flag once;
-    static Json::StreamWriterBuilder builder;
-    std::call_once(once, []()
-                   {
-        builder["commentStyle"] = "None";
-        builder["indentation"] = "";
-        if (!app().isUnicodeEscapingUsedInJson())
-        {
-            builder["emitUTF8"] = true;
-        }
-        auto &precision = app().getFloatPrecisionInJson();
-        if (precision.first != 0)
-        {
-            builder["precision"] = precision.first;
-            builder["precisionType"] = precision.second;
-        } });
-    bodyPtr_ = std::make_shared<HttpMessageStringBody>(
-        writeString(builder, *jsonPtr_));
+    // Serialized straight into the body, without an intermediate string
+    auto body = std::make_shared<HttpMessageBufferBody>();
+    HttpAppFrameworkImpl::instance().getJsonBackend()->serialize(
+        *jsonPtr_, body->buffer());
+    bodyPtr_ = std::move(body);
 }
 
 void HttpResponseImpl::makeHeaderString(xiaoNet::MsgBuffer &buffer)
@@ -583,7 +505,7 @@ void HttpResponseImpl::makeHeaderString(xiaoNet::MsgBuffer &buffer)
         }
         else
         {
-            auto bodyLength = sendfileRange_.second;
+            auto bodyLength = sendfileLength();
             len = snprintf(buffer.beginWrite(),
                            buffer.writableBytes(),
                            contentLengthFormatString<decltype(bodyLength)>(),
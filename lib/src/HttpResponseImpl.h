@@ -12,9 +12,12 @@
 
 #include "HttpUtils.h"
 #include "HttpMessageBody.h"
+#include "HttpCompressor.h"
 #include <xiaoHttp/HttpResponse.h>
 #include <xiaoHttp/HttpTypes.h>
 #include <xiaoHttp/Cookie.h>
+#include <array>
+#include <mutex>
 
 namespace xiaoHttp
 {
@@ -204,6 +207,8 @@ namespace xiaoHttp
         void setBody(const std::string &body) override
         {
             bodyPtr_ = std::make_shared<HttpMessageStringBody>(body);
+            if (compressedVariants_)
+                resetCompressedVariants();
             if (passThrough_)
             {
                 addHeader("content-length", std::to_string(bodyPtr_->length()));
@@ -213,6 +218,8 @@ namespace xiaoHttp
         void setBody(std::string &&body) override
         {
             bodyPtr_ = std::make_shared<HttpMessageStringBody>(std::move(body));
+            if (compressedVariants_)
+                resetCompressedVariants();
             if (passThrough_)
             {
                 addHeader("content-length", std::to_string(bodyPtr_->length()));
@@ -226,13 +233,23 @@ namespace xiaoHttp
 
         std::shared_ptr<xiaoNet::MsgBuffer> renderToBuffer();
         void renderToBuffer(xiaoNet::MsgBuffer &buffer);
+        /// Render the status line, the headers and the empty line that ends
+        /// them, but not the body.
+        void renderHeaderToBuffer(xiaoNet::MsgBuffer &buffer);
         std::shared_ptr<xiaoNet::MsgBuffer> renderHeaderForHeadMethod();
         void clear() override;
 
         void setExpiredTime(ssize_t expiredTime) override
         {
+            if (frozen_)
+            {
+                LOG_ERROR << "A frozen response can not be modified";
+                return;
+            }
             expriedTime_ = expiredTime;
+            httpString_.reset();
             datePos_ = std::string::npos;
+            resetCompressedVariants();
             if (expriedTime_ < 0 && version_ == Version::kHttp10)
             {
                 fullHeaderString_.reset();
@@ -244,6 +261,46 @@ namespace xiaoHttp
             return expriedTime_;
         }
 
+        void freeze() override;
+
+        bool isFrozen() const override
+        {
+            return frozen_;
+        }
+
+        /// Turn a copy of a cached or frozen response into an ordinary one
+        /// that can be modified, its rendered header is dropped.
+        void detachFromCache()
+        {
+            frozen_ = false;
+            expriedTime_ = -1;
+            httpString_.reset();
+            datePos_ = std::string::npos;
+            compressedVariants_.reset();
+        }
+
+        /**
+         * @brief The compressed copies of a cached or frozen response, one
+         * per coding.
+         *
+         * A copy is made the first time a client accepts its coding and is
+         * dropped with the response or when its body or expiration changes.
+         * The set is shared by the IO threads that serve the response.
+         */
+        struct CompressedVariants
+        {
+            std::mutex mutex;
+            std::array<HttpResponsePtr,
+                       static_cast<size_t>(ContentCoding::kCount)>
+                responses;
+        };
+
+        /// nullptr if the response is neither cached nor frozen.
+        const std::shared_ptr<CompressedVariants> &compressedVariants() const
+        {
+            return compressedVariants_;
+        }
+
         const char *getBodyData() const override
         {
             if (!flagForSerializingJson_ && jsonPtr_)
@@ -264,6 +321,21 @@ namespace xiaoHttp
             return 0;
         }
 
+        /// The storage of the body, so it can be sent without being copied.
+        const std::shared_ptr<HttpMessageBody> &bodyStorage() const
+        {
+            return bodyPtr_;
+        }
+
+        /// Return false if the status code (1xx, 204) forbids a body.
+        bool contentLengthIsAllowed() const
+        {
+            int statusCode =
+                customStatusCode_ >= 0 ? customStatusCode_ : statusCode_;
+            return (statusCode >= k200OK || statusCode < k100Continue) &&
+                   statusCode != k204NoContent;
+        }
+
         void swap(HttpResponseImpl &that) noexcept;
         void parseJson() const;
 
@@ -301,6 +373,8 @@ namespace xiaoHttp
             jsonPtr_ = std::make_shared<Json::Value>(std::move(pJson));
         }
 
+        /// Return false if the body can not be compressed. The size and the
+        /// type of the body are checked by the compression policy.
         bool shouldBeCompressed() const;
         void generateBodyFromJson() const;
 
@@ -335,6 +409,49 @@ namespace xiaoHttp
             sendfileRange_.second = len;
         }
 
+        /// A part of a multipart/byteranges body, the boundary and the
+        /// headers of the part are sent before its range of the file.
+        struct SendfilePart
+        {
+            std::string head;
+            SendfileRange range;
+        };
+
+        /**
+         * @brief Send several ranges of the sendfile as a multipart body.
+         *
+         * @param trailer The closing boundary, sent after the last part.
+         */
+        void setSendfileParts(std::vector<SendfilePart> parts,
+                              std::string trailer)
+        {
+            sendfileParts_ = std::move(parts);
+            sendfileTrailer_ = std::move(trailer);
+        }
+
+        const std::vector<SendfilePart> &sendfileParts() const
+        {
+            return sendfileParts_;
+        }
+
+        const std::string &sendfileTrailer() const
+        {
+            return sendfileTrailer_;
+        }
+
+        /// The length of the body sent from the sendfile.
+        size_t sendfileLength() const
+        {
+            if (sendfileParts_.empty())
+                return sendfileRange_.second;
+            auto length = sendfileTrailer_.size();
+            for (auto const &part : sendfileParts_)
+            {
+                length += part.head.size() + part.range.second;
+            }
+            return length;
+        }
+
         const std::function<std::size_t(char *, std::size_t)> &streamCallback()
             const override
         {
@@ -408,6 +525,9 @@ namespace xiaoHttp
 
     protected:
         void makeHeaderString(xiaoNet::MsgBuffer &headerString);
+        // Render the header and return the offset of the date value in the
+        // rendered bytes, or npos if no date header is sent.
+        size_t renderHeader(xiaoNet::MsgBuffer &buffer);
 
         void parseContentTypeAndString() const
         {
@@ -444,6 +564,8 @@ namespace xiaoHttp
         void setBody(const char *body, size_t len) override
         {
             bodyPtr_ = std::make_shared<HttpMessageStringViewBody>(body, len);
+            if (compressedVariants_)
+                resetCompressedVariants();
             if (passThrough_)
             {
                 addHeader("content-length", std::to_string(bodyPtr_->length()));
@@ -496,6 +618,8 @@ namespace xiaoHttp
         ssize_t expriedTime_{-1};
         std::string sendfileName_;
         SendfileRange sendfileRange_{0, 0};
+        std::vector<SendfilePart> sendfileParts_;
+        std::string sendfileTrailer_;
         std::function<std::size_t(char *, std::size_t)> streamCallback_;
         std::function<void(ResponseStreamPtr)> asyncStreamCallback_;
         bool asyncStreamDisableKickoff_{false};
@@ -505,8 +629,12 @@ namespace xiaoHttp
         std::shared_ptr<xiaoNet::MsgBuffer> fullHeaderString_;
         xiaoNet::CertificatePtr peerCertificate_;
         mutable std::shared_ptr<xiaoNet::MsgBuffer> httpString_;
+        // Position of the date value in httpString_, npos if there is none
         mutable size_t datePos_{static_cast<size_t>(-1)};
-        mutable int64_t httpStringDate_{-1};
+        // httpString_ and the body were rendered by freeze() and are only
+        // read from then on.
+        bool frozen_{false};
+        std::shared_ptr<CompressedVariants> compressedVariants_;
         mutable bool flagForParsingJson_{false};
         mutable bool flagForSerializingJson_{true};
         mutable ContentType contentType_{CT_TEXT_PLAIN};
@@ -515,6 +643,14 @@ namespace xiaoHttp
         mutable std::string contentTypeString_{"text/html; charset=utf-8"};
         bool passThrough_{false};
 
+        void resetCompressedVariants()
+        {
+            if (expriedTime_ >= 0 || frozen_)
+                compressedVariants_ = std::make_shared<CompressedVariants>();
+            else
+                compressedVariants_.reset();
+        }
+
         void setContentType(const std::string_view &contentType)
         {
             contentTypeString_ =
@@ -0,0 +1,192 @@
+/**
+ * @file HttpRouteTrie.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-10
+ *
+ *
+ */
+
+#include "HttpRouteTrie.h"
+#include <algorithm>
+#include <cctype>
+
+using namespace xiaoHttp;
+
+static constexpr std::string_view paramSegment = "([^/]*)";
+static constexpr std::string_view tailSegment = "(.*)";
+
+// Turn a regex segment into the literal it matches, fail if the segment
+// uses any regex feature.
+static bool segmentToLiteral(std::string_view segment, std::string &literal)
+{
+    static constexpr std::string_view metaChars = ".^$|()[]{}*+?";
+    literal.clear();
+    for (size_t i = 0; i < segment.length(); ++i)
+    {
+        auto c = static_cast<unsigned char>(segment[i]);
+        if (c == '\\')
+        {
+            if (i + 1 == segment.length())
+                return false;
+            c = static_cast<unsigned char>(segment[++i]);
+            // \d, \w, \b... are character classes, not escapes
+            if (isalnum(c))
+                return false;
+        }
+        else if (metaChars.find(static_cast<char>(c)) != std::string_view::npos)
+        {
+            return false;
+        }
+        literal.push_back(static_cast<char>(tolower(c)));
+    }
+    return true;
+}
+
+static void insertSorted(std::vector<size_t> &vec, size_t index)
+{
+    vec.insert(std::upper_bound(vec.begin(), vec.end(), index), index);
+}
+
+bool HttpRouteTrie::insert(std::string_view pattern, size_t index)
+{
+    if (pattern.empty() || pattern[0] != '/')
+        return false;
+
+    // Validate the whole pattern first so that a rejected route leaves the
+    // trie untouched.
+    enum class SegmentType
+    {
+        Static,
+        Param,
+        Tail
+    };
+    std::vector<std::pair<SegmentType, std::string>> segments;
+    size_t pos = 1;
+    while (true)
+    {
+        // The parameter segment contains a '/' itself
+        auto slash =
+            pattern.substr(pos, paramSegment.length()) == paramSegment
+                ? pattern.find('/', pos + paramSegment.length())
+                : pattern.find('/', pos);
+        auto end = slash == std::string_view::npos ? pattern.length() : slash;
+        auto segment = pattern.substr(pos, end - pos);
+        if (segment == paramSegment)
+        {
+            segments.emplace_back(SegmentType::Param, std::string());
+        }
+        else if (segment == tailSegment && end == pattern.length())
+        {
+            segments.emplace_back(SegmentType::Tail, std::string());
+        }
+        else
+        {
+            std::string literal;
+            if (!segmentToLiteral(segment, literal))
+                return false;
+            segments.emplace_back(SegmentType::Static, std::move(literal));
+        }
+        if (slash == std::string_view::npos)
+            break;
+        pos = slash + 1;
+    }
+
+    Node *node = &root_;
+    node->minIndex = std::min(node->minIndex, index);
+    for (auto &[type, literal] : segments)
+    {
+        if (type == SegmentType::Tail)
+        {
+            insertSorted(node->tailRoutes, index);
+            return true;
+        }
+        std::unique_ptr<Node> *child;
+        if (type == SegmentType::Param)
+        {
+            child = &node->paramChild;
+        }
+        else
+        {
+            child = &node->staticChildren[literal];
+        }
+        if (!*child)
+            *child = std::make_unique<Node>();
+        node = child->get();
+        node->minIndex = std::min(node->minIndex, index);
+    }
+    insertSorted(node->routes, index);
+    return true;
+}
+
+size_t HttpRouteTrie::match(std::string_view lowerPath,
+                            const std::function<bool(size_t)> &accept,
+                            Captures &captures) const
+{
+    captures.clear();
+    if (empty() || lowerPath.empty() || lowerPath[0] != '/')
+        return npos;
+    MatchContext ctx{lowerPath, accept, {}, captures, npos};
+    matchNode(root_, 1, ctx);
+    return ctx.bestIndex;
+}
+
+void HttpRouteTrie::matchNode(const Node &node,
+                              size_t pos,
+                              MatchContext &ctx) const
+{
+    // Nothing in this subtree can beat what was already found.
+    if (node.minIndex >= ctx.bestIndex)
+        return;
+
+    auto &path = ctx.path;
+    for (auto index : node.tailRoutes)
+    {
+        if (index >= ctx.bestIndex)
+            break;
+        if (ctx.accept(index))
+        {
+            ctx.bestIndex = index;
+            ctx.best = ctx.current;
+            ctx.best.emplace_back(pos, path.length() - pos);
+            break;
+        }
+    }
+
+    auto slash = path.find('/', pos);
+    auto end = slash == std::string_view::npos ? path.length() : slash;
+    auto visit = [&](const Node &child)
+    {
+        if (slash == std::string_view::npos)
+        {
+            for (auto index : child.routes)
+            {
+                if (index >= ctx.bestIndex)
+                    break;
+                if (ctx.accept(index))
+                {
+                    ctx.bestIndex = index;
+                    ctx.best = ctx.current;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            matchNode(child, slash + 1, ctx);
+        }
+    };
+
+    auto iter = node.staticChildren.find(path.substr(pos, end - pos));
+    if (iter != node.staticChildren.end())
+    {
+        visit(*iter->second);
+    }
+    if (node.paramChild && node.paramChild->minIndex < ctx.bestIndex)
+    {
+        ctx.current.emplace_back(pos, end - pos);
+        visit(*node.paramChild);
+        ctx.current.pop_back();
+    }
+}
@@ -0,0 +1,113 @@
+/**
+ * @file HttpRouteTrie.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-10
+ *
+ *
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace xiaoHttp
+{
+    /**
+     * @brief A trie of path segments for the routes that do not need a
+     * regular expression engine.
+     *
+     * A route is given in the regex form stored in
+     * HttpControllerRouterItem::pathParameterPattern_. Each segment must be
+     * a literal, "([^/]*)" (one path parameter) or, for the last segment,
+     * "(.*)" (the rest of the path). Static segments are compared case
+     * insensitively, like the regexes they replace.
+     *
+     * When several routes match a path, the one with the lowest index wins,
+     * which is the order HttpControllersRouter used to try the regexes in.
+     */
+    class HttpRouteTrie
+    {
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        // (offset, length) of a capture in the matched path
+        using Captures = std::vector<std::pair<size_t, size_t>>;
+
+        /**
+         * @brief Add a route.
+         *
+         * @param pattern The regex form of the route.
+         * @param index The priority of the route, lower is tried first.
+         * @return false if the pattern can not be represented in the trie,
+         * nothing is added in this case.
+         */
+        bool insert(std::string_view pattern, size_t index);
+
+        /**
+         * @brief Find the route with the lowest index that matches the path
+         * and is accepted by @p accept.
+         *
+         * @param lowerPath The lowercase request path.
+         * @param captures Set to the captures of the matched route.
+         * @return The index of the route or npos.
+         */
+        size_t match(std::string_view lowerPath,
+                     const std::function<bool(size_t)> &accept,
+                     Captures &captures) const;
+
+        void clear()
+        {
+            root_ = Node();
+        }
+
+        bool empty() const
+        {
+            return root_.minIndex == npos;
+        }
+
+    private:
+        struct StringHash
+        {
+            using is_transparent = void;
+
+            size_t operator()(std::string_view sv) const
+            {
+                return std::hash<std::string_view>{}(sv);
+            }
+        };
+
+        struct Node
+        {
+            std::unordered_map<std::string,
+                               std::unique_ptr<Node>,
+                               StringHash,
+                               std::equal_to<>>
+                staticChildren;
+            std::unique_ptr<Node> paramChild;
+            std::vector<size_t> routes;     // routes that end at this node
+            std::vector<size_t> tailRoutes; // routes ending with (.*) here
+            size_t minIndex{npos};          // lowest index in the subtree
+        };
+
+        struct MatchContext
+        {
+            std::string_view path;
+            const std::function<bool(size_t)> &accept;
+            Captures current;
+            Captures &best;
+            size_t bestIndex;
+        };
+
+        void matchNode(const Node &node, size_t pos, MatchContext &ctx) const;
+
+        Node root_;
+    };
+}
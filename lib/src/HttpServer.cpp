@@ -14,7 +14,15 @@
 
 #include "AOPAdvice.h"
 #include "HttpAppFrameworkImpl.h"
+#include "HttpCompressionPolicy.h"
 #include "HttpConnectionLimit.h"
+#include "HttpResponseCompression.h"
+#include "HttpResponseImpl.h"
+#include "ResponseStreamFlow.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 
 #if COZ_PROFILING
 #include <coz.h>
@@ -108,13 +116,36 @@ void HttpServer::onConnection(const TcpConnectionPtr &conn)
             {
                 requestParser->webSocketConn()->onClose();
             }
+            // Producers waiting for the connection to drain are released
+            if (auto flow = requestParser->responseStreamFlow().lock())
+            {
+                flow->close();
+            }
             conn->clearContext();
         }
     }
 }
 
+namespace
+{
+    // Count the time spent in a callback of the IO thread as busy time,
+    // the compression policy lowers its levels when the thread is busy.
+    struct BusyTimeGuard
+    {
+        std::chrono::steady_clock::time_point start{
+            std::chrono::steady_clock::now()};
+
+        ~BusyTimeGuard()
+        {
+            HttpCompressionPolicy::addBusyTime(
+                std::chrono::steady_clock::now() - start);
+        }
+    };
+}
+
 void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
 {
+    BusyTimeGuard busyTimeGuard;
     if (!conn->hasContext())
         return;
     auto requestParser = conn->getContext<HttpRequestParser>();
@@ -159,4 +190,300 @@ void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
     }
     onRequests(conn, requests, requestParser);
     requests.clear();
-}
\ No newline at end of file
+}
+
+// Bodies at least this large are not copied into the send buffer. The
+// bytes buffered so far are flushed and the body is handed to the
+// connection by reference. xiaoNet has no writev interface, so this trades
+// one extra write for a copy of the body.
+static constexpr size_t kSendBodyByReferenceThreshold = 64 * 1024;
+
+static void renderResponse(const TcpConnectionPtr &conn,
+                           HttpResponseImpl *respImplPtr,
+                           MsgBuffer &buffer)
+{
+    // The header of a cached response is kept rendered, only the date is
+    // patched in here. Its body is never part of that copy.
+    respImplPtr->renderHeaderToBuffer(buffer);
+    auto &body = respImplPtr->bodyStorage();
+    if (!body || body->length() == 0 ||
+        !respImplPtr->contentLengthIsAllowed())
+    {
+        return;
+    }
+    if (body->length() < kSendBodyByReferenceThreshold)
+    {
+        buffer.append(body->data(), body->length());
+        return;
+    }
+    conn->send(buffer);
+    buffer.retrieveAll();
+    if (body->bodyType() == HttpMessageBody::BodyType::kString)
+    {
+        auto stringBody = std::static_pointer_cast<HttpMessageStringBody>(body);
+        conn->send(
+            std::shared_ptr<std::string>(stringBody, &stringBody->string()));
+    }
+    else
+    {
+        conn->send(body->data(), body->length());
+    }
+}
+
+// Send the body that follows the header of a stream or file response.
+static void sendResponseBody(const TcpConnectionPtr &conn,
+                             HttpResponseImpl *respImplPtr)
+{
+    auto &asyncStreamCallback = respImplPtr->asyncStreamCallback();
+    if (asyncStreamCallback)
+    {
+        if (!respImplPtr->ifCloseConnection())
+        {
+            auto flow = std::make_shared<internal::ResponseStreamFlow>(conn);
+            flow->install();
+            if (auto parser = conn->getContext<HttpRequestParser>())
+                parser->setResponseStreamFlow(flow);
+            asyncStreamCallback(
+                std::make_unique<ResponseStream>(conn->sendAsyncStream(),
+                                                 std::move(flow)));
+        }
+        else
+        {
+            LOG_INFO << "Chunking Set CloseConnection !!!";
+        }
+        return;
+    }
+    auto &streamCallback = respImplPtr->streamCallback();
+    if (streamCallback)
+    {
+        if (respImplPtr->getHeaderBy("transfer-encoding") != "chunked")
+        {
+            conn->sendStream(streamCallback);
+            return;
+        }
+        // Wrap every piece produced by the callback into a chunk. The size
+        // is written with a fixed width so it can be placed before the data.
+        auto finished = std::make_shared<bool>(false);
+        conn->sendStream(
+            [streamCallback, finished](char *buffer,
+                                       std::size_t len) -> std::size_t
+            {
+                static constexpr std::size_t headLen = 10; // "%08x\r\n"
+                static constexpr std::size_t tailLen = 2;  // "\r\n"
+                static constexpr std::size_t lastLen = 5;  // "0\r\n\r\n"
+                if (buffer == nullptr)
+                    return streamCallback(nullptr, 0);
+                if (*finished)
+                    return 0;
+                std::size_t n = 0;
+                if (len >= headLen + tailLen + 1)
+                {
+                    n = streamCallback(buffer + headLen,
+                                       len - headLen - tailLen);
+                }
+                else
+                {
+                    // The connection never passes such a small buffer, the
+                    // body is cut but still ends with the last chunk.
+                    LOG_ERROR << "No room for a chunk in " << len << " bytes";
+                }
+                if (n == 0)
+                {
+                    *finished = true;
+                    if (len < lastLen)
+                        return 0;
+                    memcpy(buffer, "0\r\n\r\n", lastLen);
+                    return lastLen;
+                }
+                char head[headLen + 1];
+                snprintf(head, sizeof(head), "%08zx\r\n", n);
+                memcpy(buffer, head, headLen);
+                memcpy(buffer + headLen + n, "\r\n", tailLen);
+                return headLen + n + tailLen;
+            });
+        return;
+    }
+    const std::string &sendfileName = respImplPtr->sendfileName();
+    if (sendfileName.empty())
+        return;
+    auto &parts = respImplPtr->sendfileParts();
+    if (parts.empty())
+    {
+        const auto &range = respImplPtr->sendfileRange();
+        conn->sendFile(sendfileName.c_str(), range.first, range.second);
+        return;
+    }
+    // The connection keeps the order of its writes, so the boundaries are
+    // sent from memory between the file ranges.
+    for (auto const &part : parts)
+    {
+        conn->send(part.head);
+        conn->sendFile(sendfileName.c_str(),
+                       part.range.first,
+                       part.range.second);
+    }
+    conn->send(respImplPtr->sendfileTrailer());
+}
+
+static inline bool hasSeparateBody(HttpResponseImpl *respImplPtr)
+{
+    return respImplPtr->asyncStreamCallback() ||
+           respImplPtr->streamCallback() ||
+           !respImplPtr->sendfileName().empty();
+}
+
+void HttpServer::sendResponse(const TcpConnectionPtr &conn,
+                              const HttpResponsePtr &response,
+                              bool isHeadMethod)
+{
+    conn->getLoop()->assertInLoopThread();
+    auto respImplPtr = static_cast<HttpResponseImpl *>(response.get());
+    if (!isHeadMethod)
+    {
+        MsgBuffer buffer;
+        renderResponse(conn, respImplPtr, buffer);
+        if (buffer.readableBytes() > 0)
+            conn->send(std::move(buffer));
+        if (hasSeparateBody(respImplPtr))
+            sendResponseBody(conn, respImplPtr);
+    }
+    else
+    {
+        auto httpString = respImplPtr->renderHeaderForHeadMethod();
+        conn->send(std::move(*httpString));
+    }
+    COZ_PROGRESS
+}
+
+void HttpServer::sendResponses(
+    const TcpConnectionPtr &conn,
+    const std::vector<std::pair<HttpResponsePtr, bool>> &responses,
+    MsgBuffer &buffer)
+{
+    conn->getLoop()->assertInLoopThread();
+    if (responses.empty())
+        return;
+    if (responses.size() == 1)
+    {
+        sendResponse(conn, responses[0].first, responses[0].second);
+        return;
+    }
+    // Small responses of a pipelined batch are coalesced into one buffer and
+    // written together, large bodies are sent by reference.
+    for (auto const &resp : responses)
+    {
+        auto respImplPtr = static_cast<HttpResponseImpl *>(resp.first.get());
+        if (!resp.second)
+        {
+            // Not HEAD method
+            renderResponse(conn, respImplPtr, buffer);
+            if (!hasSeparateBody(respImplPtr))
+                continue;
+            conn->send(buffer);
+            buffer.retrieveAll();
+            sendResponseBody(conn, respImplPtr);
+        }
+        else
+        {
+            auto httpString = respImplPtr->renderHeaderForHeadMethod();
+            buffer.append(httpString->peek(), httpString->readableBytes());
+        }
+        COZ_PROGRESS
+    }
+    if (conn->connected() && buffer.readableBytes() > 0)
+    {
+        conn->send(buffer);
+        buffer.retrieveAll();
+    }
+}
+
+static inline HttpResponsePtr getCompressdResponse(
+    const HttpRequestImplPtr &req,
+    const HttpResponsePtr &response,
+    bool isHeadMethod)
+{
+    if (isHeadMethod)
+        return response;
+    EnabledCodings enabled;
+    enabled.gzip = app().isGzipEnabled();
+    enabled.brotli = app().isBrotliEnabled();
+    enabled.zstd = app().isZstdEnabled();
+    return HttpResponseCompression::compress(
+        req->getHeaderView(KnownHeader::AcceptEncoding),
+        response,
+        app().compressionPolicy(),
+        enabled);
+}
+
+// What the callback of a request needs to send its response
+struct CallbackParamPack
+{
+    CallbackParamPack(const TcpConnectionPtr &conn,
+                      const HttpRequestImplPtr &req,
+                      const std::shared_ptr<bool> &loopFlag,
+                      const std::shared_ptr<HttpRequestParser> &requestParser,
+                      bool isHeadMethod)
+        : conn_(conn),
+          req_(req),
+          loopFlag_(loopFlag),
+          requestParser_(requestParser),
+          isHeadMethod_(isHeadMethod)
+    {
+    }
+
+    TcpConnectionPtr conn_;
+    HttpRequestImplPtr req_;
+    // True while onRequests() runs, the responses ready by then are sent
+    // together when it returns
+    std::shared_ptr<bool> loopFlag_;
+    std::shared_ptr<HttpRequestParser> requestParser_;
+    bool isHeadMethod_;
+};
+
+void HttpServer::handleResponse(
+    const HttpResponsePtr &response,
+    const std::shared_ptr<CallbackParamPack> &paramPack,
+    bool *respReadyPtr)
+{
+    auto &conn = paramPack->conn_;
+    auto &req = paramPack->req_;
+    auto &requestParser = paramPack->requestParser_;
+    auto isHeadMethod = paramPack->isHeadMethod_;
+    // Compressed before it waits in the pipeline and before it is rendered
+    auto newResp = getCompressdResponse(req, response, isHeadMethod);
+    if (conn->getLoop()->isInLoopThread() && *paramPack->loopFlag_)
+    {
+        *respReadyPtr = true;
+        if (requestParser->emptyPipelining())
+        {
+            requestParser->getResponseBuffer().emplace_back(std::move(newResp),
+                                                            isHeadMethod);
+        }
+        else if (requestParser->pushResponseToPipelining(req,
+                                                         std::move(newResp)))
+        {
+            requestParser->popReadyResponse(
+                requestParser->getResponseBuffer());
+        }
+        return;
+    }
+    conn->getLoop()->runInLoop(
+        [conn, req, requestParser, newResp = std::move(newResp), isHeadMethod]()
+        {
+            if (!conn->connected())
+                return;
+            if (requestParser->emptyPipelining())
+            {
+                sendResponse(conn, newResp, isHeadMethod);
+                return;
+            }
+            // The responses are sent in the order of the requests
+            if (requestParser->pushResponseToPipelining(req, newResp))
+            {
+                auto &responses = requestParser->getResponseBuffer();
+                requestParser->popReadyResponse(responses);
+                sendResponses(conn, responses, requestParser->getBuffer());
+                responses.clear();
+            }
+        });
+}
@@ -492,4 +492,4 @@ namespace xiaoHttp
         auto it = contentTypeMap_.find(contentType);
         return (it == contentTypeMap_.end()) ? CT_CUSTOM : it->second;
     }
-}
\ No newline at end of file
+}
@@ -12,6 +12,7 @@
 
 #include <xiaoNet/utils/MsgBuffer.h>
 #include <xiaoHttp/HttpTypes.h>
+#include "HttpFileRange.h"
 #include <string>
 
 namespace xiaoHttp
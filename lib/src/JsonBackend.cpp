@@ -0,0 +1,167 @@
+/**
+ * @file JsonBackend.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-24
+ *
+ *
+ */
+
+#include <xiaoHttp/JsonBackend.h>
+#include <xiaoHttp/HttpAppFramework.h>
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+
+using namespace xiaoHttp;
+
+namespace
+{
+    // JsonCpp writes through an ostream, this one writes straight into the
+    // writable part of a MsgBuffer instead of a string that is copied later.
+    class MsgBufferStreamBuf : public std::streambuf
+    {
+    public:
+        explicit MsgBufferStreamBuf(xiaoNet::MsgBuffer &buffer)
+            : buffer_(buffer)
+        {
+            buffer_.ensureWritableBytes(256);
+            resetPutArea();
+        }
+
+        ~MsgBufferStreamBuf() override
+        {
+            commit();
+        }
+
+    protected:
+        int_type overflow(int_type ch) override
+        {
+            commit();
+            // Grown by the size of the text so far, like a string would
+            buffer_.ensureWritableBytes(buffer_.readableBytes() + 1);
+            resetPutArea();
+            if (!traits_type::eq_int_type(ch, traits_type::eof()))
+            {
+                *pptr() = traits_type::to_char_type(ch);
+                pbump(1);
+            }
+            return traits_type::not_eof(ch);
+        }
+
+        std::streamsize xsputn(const char *s, std::streamsize n) override
+        {
+            if (n > epptr() - pptr())
+            {
+                commit();
+                buffer_.append(s, static_cast<size_t>(n));
+                resetPutArea();
+                return n;
+            }
+            traits_type::copy(pptr(), s, static_cast<size_t>(n));
+            pbump(static_cast<int>(n));
+            return n;
+        }
+
+    private:
+        void commit()
+        {
+            buffer_.hasWritten(static_cast<size_t>(pptr() - pbase()));
+            setp(nullptr, nullptr);
+        }
+
+        void resetPutArea()
+        {
+            setp(buffer_.beginWrite(),
+                 buffer_.beginWrite() + buffer_.writableBytes());
+        }
+
+        xiaoNet::MsgBuffer &buffer_;
+    };
+
+    class JsonCppBackend : public JsonBackend
+    {
+    public:
+        JsonCppBackend() : id_(nextId_.fetch_add(1))
+        {
+        }
+
+        bool parse(const char *begin,
+                   const char *end,
+                   Json::Value &root,
+                   std::string &errs) const override
+        {
+            return threadCache().reader->parse(begin, end, &root, &errs);
+        }
+
+        void serialize(const Json::Value &value,
+                       xiaoNet::MsgBuffer &buffer) const override
+        {
+            MsgBufferStreamBuf streamBuf(buffer);
+            std::ostream os(&streamBuf);
+            threadCache().writer->write(value, &os);
+        }
+
+    private:
+        struct ThreadCache
+        {
+            uint64_t backendId{0};
+            std::unique_ptr<Json::CharReader> reader;
+            std::unique_ptr<Json::StreamWriter> writer;
+        };
+
+        // The builders read the settings of the app when the first message
+        // is handled, after the app has been configured.
+        void initBuilders() const
+        {
+            std::call_once(once_, [this]() {
+                readerBuilder_["collectComments"] = false;
+                readerBuilder_["stackLimit"] = static_cast<Json::UInt>(
+                    app().getJsonParserStackLimit());
+                writerBuilder_["commentStyle"] = "None";
+                writerBuilder_["indentation"] = "";
+                if (!app().isUnicodeEscapingUsedInJson())
+                {
+                    writerBuilder_["emitUTF8"] = true;
+                }
+                auto &precision = app().getFloatPrecisionInJson();
+                if (precision.first != 0)
+                {
+                    writerBuilder_["precision"] = precision.first;
+                    writerBuilder_["precisionType"] = precision.second;
+                }
+            });
+        }
+
+        // One reader and writer per thread, they are rebuilt if another
+        // JsonCpp backend was used last on the thread.
+        ThreadCache &threadCache() const
+        {
+            static thread_local ThreadCache cache;
+            if (cache.backendId != id_)
+            {
+                initBuilders();
+                cache.reader.reset(readerBuilder_.newCharReader());
+                cache.writer.reset(writerBuilder_.newStreamWriter());
+                cache.backendId = id_;
+            }
+            return cache;
+        }
+
+        static std::atomic<uint64_t> nextId_;
+        const uint64_t id_;
+        mutable std::once_flag once_;
+        mutable Json::CharReaderBuilder readerBuilder_;
+        mutable Json::StreamWriterBuilder writerBuilder_;
+    };
+
+    // 0 is left for a thread that has not used any backend
+    std::atomic<uint64_t> JsonCppBackend::nextId_{1};
+}
+
+JsonBackendPtr JsonBackend::newJsonCppBackend()
+{
+    return std::make_shared<JsonCppBackend>();
+}
@@ -0,0 +1,108 @@
+/**
+ * @file LruCache.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-10
+ *
+ *
+ */
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace xiaoHttp
+{
+    /**
+     * @brief A bounded map from string keys to values that evicts the least
+     * recently used entry when it is full.
+     *
+     * This class is not thread-safe, it is meant to be used through
+     * IOThreadStorage. A lookup does not allocate, the node of an evicted
+     * entry is reused for the new one.
+     */
+    template <typename T>
+    class LruCache
+    {
+    public:
+        explicit LruCache(size_t capacity = 0) : capacity_(capacity)
+        {
+        }
+
+        /// Return the value of the key and mark it as recently used, or
+        /// nullptr if the key is not cached.
+        T *find(std::string_view key)
+        {
+            auto iter = map_.find(key);
+            if (iter == map_.end())
+                return nullptr;
+            entries_.splice(entries_.begin(), entries_, iter->second);
+            return &iter->second->second;
+        }
+
+        void insert(std::string_view key, T value)
+        {
+            if (capacity_ == 0)
+                return;
+            auto iter = map_.find(key);
+            if (iter != map_.end())
+            {
+                iter->second->second = std::move(value);
+                entries_.splice(entries_.begin(), entries_, iter->second);
+                return;
+            }
+            if (map_.size() >= capacity_)
+            {
+                // Reuse the node of the least recently used entry
+                map_.erase(entries_.back().first);
+                entries_.splice(entries_.begin(), entries_, --entries_.end());
+                entries_.front().first.assign(key);
+                entries_.front().second = std::move(value);
+            }
+            else
+            {
+                entries_.emplace_front(std::string(key), std::move(value));
+            }
+            // The key string lives in the list node, which never moves.
+            map_.emplace(entries_.front().first, entries_.begin());
+        }
+
+        void erase(std::string_view key)
+        {
+            auto iter = map_.find(key);
+            if (iter == map_.end())
+                return;
+            auto node = iter->second;
+            map_.erase(iter);
+            entries_.erase(node);
+        }
+
+        void clear()
+        {
+            map_.clear();
+            entries_.clear();
+        }
+
+        size_t size() const
+        {
+            return map_.size();
+        }
+
+        size_t capacity() const
+        {
+            return capacity_;
+        }
+
+    private:
+        using Entry = std::pair<std::string, T>;
+        std::list<Entry> entries_;
+        std::unordered_map<std::string_view, typename std::list<Entry>::iterator>
+            map_;
+        size_t capacity_;
+    };
+}
@@ -0,0 +1,374 @@
+/**
+ * @file MultipartStreamParser.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-18
+ *
+ *
+ */
+
+#include "MultipartStreamParser.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define XIAOHTTP_BOUNDARY_X86 1
+#endif
+
+using namespace xiaoHttp;
+
+// The headers of a part are refused beyond this size
+static constexpr size_t kMaxPartHeaderSize = 16 * 1024;
+
+static bool equalsIgnoreCase(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() &&
+           std::equal(a.begin(),
+                      a.end(),
+                      b.begin(),
+                      [](unsigned char x, unsigned char y)
+                      { return tolower(x) == tolower(y); });
+}
+
+static std::string_view trim(std::string_view str)
+{
+    auto begin = str.find_first_not_of(" \t");
+    if (begin == std::string_view::npos)
+        return {};
+    return str.substr(begin, str.find_last_not_of(" \t") + 1 - begin);
+}
+
+// Return the value of a parameter like name="value" or name=value
+static std::string_view parameterOf(std::string_view params,
+                                    std::string_view name)
+{
+    while (!params.empty())
+    {
+        auto semicolon = params.find(';');
+        auto param = trim(params.substr(0, semicolon));
+        params = semicolon == std::string_view::npos
+                     ? std::string_view{}
+                     : params.substr(semicolon + 1);
+        auto equal = param.find('=');
+        if (equal == std::string_view::npos ||
+            !equalsIgnoreCase(trim(param.substr(0, equal)), name))
+            continue;
+        auto value = trim(param.substr(equal + 1));
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+            value = value.substr(1, value.size() - 2);
+        return value;
+    }
+    return {};
+}
+
+BoundarySearcher::BoundarySearcher(std::string pattern)
+    : pattern_(std::move(pattern))
+{
+    auto length = pattern_.size();
+    skip_.fill(static_cast<uint8_t>(length));
+    // The shift for a byte is its distance to the end of the pattern, the
+    // last byte is left out so that a shift is never 0.
+    for (size_t i = 0; i + 1 < length; ++i)
+        skip_[static_cast<unsigned char>(pattern_[i])] =
+            static_cast<uint8_t>(length - 1 - i);
+}
+
+#ifdef XIAOHTTP_BOUNDARY_X86
+// The candidates of a block are the positions where both the first and the
+// last byte of the pattern match, only those are compared in full. Return
+// the first position from which fewer than a block of candidates is left
+// when nothing is found.
+static size_t filterSse2(std::string_view text,
+                         size_t pos,
+                         const std::string &pattern,
+                         size_t &found)
+{
+    auto length = pattern.size();
+    const __m128i first = _mm_set1_epi8(pattern.front());
+    const __m128i last = _mm_set1_epi8(pattern.back());
+    const char *data = text.data();
+    for (; pos + length - 1 + 16 <= text.size(); pos += 16)
+    {
+        const __m128i a =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+        const __m128i b = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(data + pos + length - 1));
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+        while (mask)
+        {
+            auto candidate = pos + __builtin_ctz(mask);
+            if (memcmp(data + candidate + 1, pattern.data() + 1, length - 2) ==
+                0)
+            {
+                found = candidate;
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return pos;
+}
+
+__attribute__((target("avx2"))) static size_t filterAvx2(
+    std::string_view text,
+    size_t pos,
+    const std::string &pattern,
+    size_t &found)
+{
+    auto length = pattern.size();
+    const __m256i first = _mm256_set1_epi8(pattern.front());
+    const __m256i last = _mm256_set1_epi8(pattern.back());
+    const char *data = text.data();
+    for (; pos + length - 1 + 32 <= text.size(); pos += 32)
+    {
+        const __m256i a =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+        const __m256i b = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(data + pos + length - 1));
+        auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+        while (mask)
+        {
+            auto candidate = pos + __builtin_ctz(mask);
+            if (memcmp(data + candidate + 1, pattern.data() + 1, length - 2) ==
+                0)
+            {
+                found = candidate;
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return filterSse2(text, pos, pattern, found);
+}
+
+using FilterFunc = size_t (*)(std::string_view,
+                              size_t,
+                              const std::string &,
+                              size_t &);
+
+static FilterFunc filterFunc()
+{
+    static const FilterFunc func = []() -> FilterFunc
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return filterAvx2;
+        return filterSse2;
+    }();
+    return func;
+}
+#endif
+
+size_t BoundarySearcher::find(std::string_view text, size_t pos) const
+{
+    auto length = pattern_.size();
+    if (length == 0 || text.size() < length)
+        return std::string_view::npos;
+#ifdef XIAOHTTP_BOUNDARY_X86
+    // The whole blocks are filtered with SIMD, the tail goes on below
+    if (length > 1)
+    {
+        size_t found = std::string_view::npos;
+        pos = filterFunc()(text, pos, pattern_, found);
+        if (found != std::string_view::npos)
+            return found;
+    }
+#endif
+    const char last = pattern_.back();
+    const char *data = text.data();
+    for (auto end = text.size() - length; pos <= end;)
+    {
+        const char c = data[pos + length - 1];
+        if (c == last && memcmp(data + pos, pattern_.data(), length - 1) == 0)
+            return pos;
+        pos += skip_[static_cast<unsigned char>(c)];
+    }
+    return std::string_view::npos;
+}
+
+size_t BoundarySearcher::partialMatch(std::string_view text) const
+{
+    auto longest = std::min(text.size(), pattern_.size() - 1);
+    for (auto length = longest; length > 0; --length)
+    {
+        auto begin = text.size() - length;
+        if (text[begin] == pattern_[0] &&
+            memcmp(text.data() + begin, pattern_.data(), length) == 0)
+            return begin;
+    }
+    return text.size();
+}
+
+std::string_view MultipartStreamParser::boundaryOf(std::string_view contentType)
+{
+    auto semicolon = contentType.find(';');
+    if (semicolon == std::string_view::npos)
+        return {};
+    return parameterOf(contentType.substr(semicolon + 1), "boundary");
+}
+
+MultipartStreamParser::MultipartStreamParser(std::string_view contentType)
+{
+    auto boundary = boundaryOf(contentType);
+    // rfc2046-5.1.1, the boundary is 1 to 70 characters long
+    if (boundary.empty() || boundary.size() > 70)
+    {
+        status_ = Status::kError;
+        return;
+    }
+    dashBoundaryCrlf_ =
+        BoundarySearcher(std::string("--").append(boundary).append("\r\n"));
+    crlfDashBoundary_ =
+        BoundarySearcher(std::string("\r\n--").append(boundary));
+}
+
+void MultipartStreamParser::parse(const char *data,
+                                  size_t length,
+                                  const HeaderCallback &headerCb,
+                                  const DataCallback &dataCb)
+{
+    if (status_ == Status::kError || status_ == Status::kFinished)
+        return;
+    // The piece is parsed where it is unless bytes are left from the last
+    // one, only the bytes that are not consumed are copied.
+    if (buffer_.empty())
+    {
+        std::string_view input(data, length);
+        auto consumed = parseInput(input, headerCb, dataCb);
+        buffer_.assign(input.substr(consumed));
+        return;
+    }
+    buffer_.append(data, length);
+    auto consumed = parseInput(buffer_, headerCb, dataCb);
+    buffer_.erase(0, consumed);
+}
+
+size_t MultipartStreamParser::parseInput(std::string_view input,
+                                         const HeaderCallback &headerCb,
+                                         const DataCallback &dataCb)
+{
+    size_t pos = 0;
+    while (pos < input.size())
+    {
+        switch (status_)
+        {
+        case Status::kExpectFirstBoundary:
+        {
+            // A preamble before the first boundary is skipped
+            auto found = dashBoundaryCrlf_.find(input, pos);
+            if (found == std::string_view::npos)
+                return std::max(pos,
+                                dashBoundaryCrlf_.partialMatch(input));
+            pos = found + dashBoundaryCrlf_.size();
+            status_ = Status::kExpectHeader;
+            break;
+        }
+        case Status::kExpectNewEntry:
+        {
+            if (input.size() - pos < 2)
+                return pos;
+            auto next = input.substr(pos, 2);
+            pos += 2;
+            if (next == "\r\n")
+            {
+                status_ = Status::kExpectHeader;
+            }
+            else if (next == "--")
+            {
+                // The epilogue after the closing boundary is ignored
+                status_ = Status::kFinished;
+                return input.size();
+            }
+            else
+            {
+                status_ = Status::kError;
+                return input.size();
+            }
+            break;
+        }
+        case Status::kExpectHeader:
+        {
+            auto end = input.find("\r\n\r\n", pos);
+            if (end == std::string_view::npos)
+            {
+                if (input.size() - pos > kMaxPartHeaderSize)
+                {
+                    status_ = Status::kError;
+                    return input.size();
+                }
+                return pos;
+            }
+            MultipartHeader header;
+            if (!parseHeader(input.substr(pos, end + 2 - pos), header))
+            {
+                status_ = Status::kError;
+                return input.size();
+            }
+            pos = end + 4;
+            status_ = Status::kExpectBody;
+            headerCb(std::move(header));
+            break;
+        }
+        case Status::kExpectBody:
+        {
+            auto found = crlfDashBoundary_.find(input, pos);
+            if (found == std::string_view::npos)
+            {
+                // The tail may be the start of a boundary split by the read
+                auto end = std::max(pos, crlfDashBoundary_.partialMatch(input));
+                if (end > pos)
+                    dataCb(input.data() + pos, end - pos);
+                return end;
+            }
+            if (found > pos)
+                dataCb(input.data() + pos, found - pos);
+            pos = found + crlfDashBoundary_.size();
+            status_ = Status::kExpectNewEntry;
+            break;
+        }
+        default:
+            return input.size();
+        }
+    }
+    return pos;
+}
+
+// Parse the header lines of a part, each ends with "\r\n"
+bool MultipartStreamParser::parseHeader(std::string_view header,
+                                        MultipartHeader &result)
+{
+    bool hasDisposition = false;
+    while (!header.empty())
+    {
+        auto end = header.find("\r\n");
+        auto line = header.substr(0, end);
+        header.remove_prefix(end + 2);
+        auto colon = line.find(':');
+        if (colon == std::string_view::npos)
+            return false;
+        auto name = trim(line.substr(0, colon));
+        auto value = trim(line.substr(colon + 1));
+        if (equalsIgnoreCase(name, "content-disposition"))
+        {
+            auto semicolon = value.find(';');
+            if (!equalsIgnoreCase(trim(value.substr(0, semicolon)),
+                                  "form-data") ||
+                semicolon == std::string_view::npos)
+                return false;
+            auto params = value.substr(semicolon + 1);
+            result.name = parameterOf(params, "name");
+            result.filename = parameterOf(params, "filename");
+            hasDisposition = true;
+        }
+        else if (equalsIgnoreCase(name, "content-type"))
+        {
+            result.contentType = value;
+        }
+    }
+    return hasDisposition;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file MultipartStreamParser.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-18
+ *
+ *
+ */
+
+#pragma once
+
+#include <xiaoHttp/RequestStream.h>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace xiaoHttp
+{
+    /**
+     * @brief The search of a multipart delimiter in the body.
+     *
+     * On x86-64 the positions where both the first and the last byte of the
+     * delimiter match are found with SSE2 or AVX2, picked once at runtime,
+     * and only those are compared in full. Elsewhere, and for the tail of
+     * the text, Boyer-Moore-Horspool is used with a skip table built once
+     * per body.
+     */
+    class BoundarySearcher
+    {
+    public:
+        BoundarySearcher() = default;
+        explicit BoundarySearcher(std::string pattern);
+
+        /// Return the position of the pattern in text at or after pos, or
+        /// npos.
+        size_t find(std::string_view text, size_t pos = 0) const;
+
+        /**
+         * @brief Return where the longest tail of text that is a prefix of
+         * the pattern begins, or text.size() if there is none.
+         *
+         * The bytes from there on may be the start of a pattern split by a
+         * read, they are the only ones that must wait for the next read.
+         */
+        size_t partialMatch(std::string_view text) const;
+
+        size_t size() const
+        {
+            return pattern_.size();
+        }
+
+    private:
+        std::string pattern_;
+        // The pattern is at most 76 bytes, so a shift fits in a byte
+        std::array<uint8_t, 256> skip_{};
+    };
+
+    /**
+     * @brief An incremental parser of multipart/form-data bodies.
+     *
+     * The body is fed in the pieces it arrives in. The data of a part is
+     * passed on as soon as it is known not to be a part of the boundary, so
+     * only the bytes that may start a boundary are kept between two calls,
+     * and a boundary split by two reads is still found.
+     */
+    class MultipartStreamParser
+    {
+    public:
+        using HeaderCallback = std::function<void(MultipartHeader header)>;
+        using DataCallback = std::function<void(const char *, size_t)>;
+
+        /// @param contentType The content-type header, with the boundary.
+        explicit MultipartStreamParser(std::string_view contentType);
+
+        /**
+         * @brief Parse the next piece of the body.
+         *
+         * @param headerCb Called when a part starts.
+         * @param dataCb Called with the data of the current part, the data
+         * of a part may come in several calls.
+         */
+        void parse(const char *data,
+                   size_t length,
+                   const HeaderCallback &headerCb,
+                   const DataCallback &dataCb);
+
+        bool isValid() const
+        {
+            return status_ != Status::kError;
+        }
+
+        /// The closing boundary was parsed.
+        bool isFinished() const
+        {
+            return status_ == Status::kFinished;
+        }
+
+        /// Extract the boundary parameter of a content type, empty if there
+        /// is none.
+        static std::string_view boundaryOf(std::string_view contentType);
+
+    private:
+        enum class Status
+        {
+            kExpectFirstBoundary,
+            kExpectNewEntry, // after a boundary, "\r\n" or "--"
+            kExpectHeader,
+            kExpectBody,
+            kFinished,
+            kError
+        };
+
+        // Return the number of bytes consumed
+        size_t parseInput(std::string_view input,
+                          const HeaderCallback &headerCb,
+                          const DataCallback &dataCb);
+        bool parseHeader(std::string_view header, MultipartHeader &result);
+
+        BoundarySearcher dashBoundaryCrlf_; // "--boundary\r\n"
+        BoundarySearcher crlfDashBoundary_; // "\r\n--boundary"
+        std::string buffer_;           // the unconsumed bytes
+        Status status_{Status::kExpectFirstBoundary};
+    };
+}
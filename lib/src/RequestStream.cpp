@@ -0,0 +1,397 @@
+/**
+ * @file RequestStream.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-18
+ *
+ *
+ */
+
+#include <xiaoHttp/RequestStream.h>
+#include "HttpRequestImpl.h"
+#include "MultipartStreamParser.h"
+#include "Digests.h"
+#include <xiaoLog/Logger.h>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+
+using namespace xiaoHttp;
+
+namespace
+{
+    // The value of a field that is not a file is kept in memory up to this
+    constexpr size_t kMaxFieldSize = 1024 * 1024;
+
+    class RequestStreamImpl : public RequestStream
+    {
+    public:
+        explicit RequestStreamImpl(const HttpRequestImplPtr &req)
+            : weakReq_(req)
+        {
+        }
+
+        void setStreamReader(RequestStreamReaderPtr reader) override
+        {
+            if (setReader_.exchange(true))
+            {
+                throw std::runtime_error("Stream reader already set!");
+            }
+            if (auto req = weakReq_.lock())
+            {
+                req->getLoop()->runInLoop(
+                    [req, reader = std::move(reader)]() mutable
+                    { req->setStreamReader(std::move(reader)); });
+            }
+        }
+
+        void setStreamReader(RequestStreamReaderPtr reader,
+                             size_t initialCredit) override
+        {
+            if (setReader_.exchange(true))
+            {
+                throw std::runtime_error("Stream reader already set!");
+            }
+            if (auto req = weakReq_.lock())
+            {
+                req->getLoop()->runInLoop(
+                    [req, reader = std::move(reader), initialCredit]() mutable
+                    {
+                        req->setStreamReader(std::move(reader),
+                                             initialCredit);
+                    });
+            }
+        }
+
+        void grantCredit(size_t bytes) override
+        {
+            // Queued even in the loop thread, so a reader granting credit
+            // from onStreamData() is not called again before it returns.
+            if (auto req = weakReq_.lock())
+            {
+                req->getLoop()->queueInLoop(
+                    [req, bytes]() { req->grantStreamCredit(bytes); });
+            }
+        }
+
+    private:
+        std::weak_ptr<HttpRequestImpl> weakReq_;
+        std::atomic_bool setReader_{false};
+    };
+
+    class DefaultStreamReader : public RequestStreamReader
+    {
+    public:
+        DefaultStreamReader(StreamDataCallback dataCb,
+                            StreamFinishCallback finishCb)
+            : dataCb_(std::move(dataCb)), finishCb_(std::move(finishCb))
+        {
+        }
+
+        void onStreamData(const char *data, size_t length) override
+        {
+            dataCb_(data, length);
+        }
+
+        void onStreamFinish(std::exception_ptr ex) override
+        {
+            finishCb_(std::move(ex));
+        }
+
+    private:
+        StreamDataCallback dataCb_;
+        StreamFinishCallback finishCb_;
+    };
+
+    class NullStreamReader : public RequestStreamReader
+    {
+    public:
+        void onStreamData(const char *, size_t) override
+        {
+        }
+
+        void onStreamFinish(std::exception_ptr) override
+        {
+        }
+    };
+
+    class MultipartStreamReader : public RequestStreamReader
+    {
+    public:
+        MultipartStreamReader(std::string_view contentType,
+                              MultipartHeaderCallback headerCb,
+                              StreamDataCallback dataCb,
+                              StreamFinishCallback finishCb)
+            : parser_(contentType),
+              headerCb_(std::move(headerCb)),
+              dataCb_(std::move(dataCb)),
+              finishCb_(std::move(finishCb))
+        {
+        }
+
+        void onStreamData(const char *data, size_t length) override
+        {
+            if (!parser_.isValid())
+                return;
+            parser_.parse(data, length, headerCb_, dataCb_);
+            if (!parser_.isValid())
+            {
+                // The error is reported once, the rest of the body is ignored
+                finishCb_(std::make_exception_ptr(
+                    StreamError(StreamErrorCode::kBadRequest,
+                                "Invalid multipart data")));
+            }
+        }
+
+        void onStreamFinish(std::exception_ptr ex) override
+        {
+            if (!parser_.isValid())
+                return;
+            if (!ex && !parser_.isFinished())
+            {
+                ex = std::make_exception_ptr(
+                    StreamError(StreamErrorCode::kBadRequest,
+                                "Incomplete multipart data"));
+            }
+            finishCb_(std::move(ex));
+        }
+
+    private:
+        MultipartStreamParser parser_;
+        MultipartHeaderCallback headerCb_;
+        StreamDataCallback dataCb_;
+        StreamFinishCallback finishCb_;
+    };
+
+    class MultipartFileReader : public RequestStreamReader
+    {
+    public:
+        MultipartFileReader(std::string_view contentType,
+                            MultipartFilePathCallback pathCb,
+                            MultipartFormCallback formCb,
+                            bool computeDigests)
+            : parser_(contentType),
+              pathCb_(std::move(pathCb)),
+              formCb_(std::move(formCb)),
+              computeDigests_(computeDigests)
+        {
+        }
+
+        ~MultipartFileReader() override
+        {
+            // Dropped before the stream finished
+            if (formCb_)
+                removeFiles();
+        }
+
+        void onStreamData(const char *data, size_t length) override
+        {
+            if (!formCb_)
+                return;
+            parser_.parse(
+                data,
+                length,
+                [this](MultipartHeader header) { startPart(std::move(header)); },
+                [this](const char *data, size_t length) {
+                    appendToPart(data, length);
+                });
+            if (!parser_.isValid())
+                fail("Invalid multipart data");
+            else if (!error_.empty())
+                fail(error_);
+        }
+
+        void onStreamFinish(std::exception_ptr ex) override
+        {
+            if (!formCb_)
+                return;
+            if (ex)
+            {
+                removeFiles();
+                finish(std::move(ex));
+                return;
+            }
+            if (!parser_.isFinished())
+            {
+                fail("Incomplete multipart data");
+                return;
+            }
+            finishPart();
+            if (!error_.empty())
+            {
+                fail(error_);
+                return;
+            }
+            finish(nullptr);
+        }
+
+    private:
+        void startPart(MultipartHeader header)
+        {
+            finishPart();
+            if (!error_.empty())
+                return;
+            if (header.filename.empty())
+            {
+                form_.fields.emplace_back(std::move(header.name),
+                                          std::string{});
+                inField_ = true;
+                return;
+            }
+            auto path = pathCb_(header);
+            if (path.empty())
+                return;
+            file_.open(path, std::ios::binary | std::ios::trunc);
+            if (!file_.is_open())
+            {
+                LOG_SYSERR << "Can't open " << path;
+                error_ = "Can't save the uploaded file";
+                return;
+            }
+            form_.files.push_back({std::move(header), std::move(path)});
+            if (computeDigests_)
+            {
+                md5_.emplace();
+                sha256_.emplace();
+            }
+        }
+
+        void appendToPart(const char *data, size_t length)
+        {
+            if (!error_.empty())
+                return;
+            if (inField_)
+            {
+                auto &value = form_.fields.back().second;
+                if (value.size() + length > kMaxFieldSize)
+                {
+                    error_ = "Multipart field too large";
+                    return;
+                }
+                value.append(data, length);
+                return;
+            }
+            if (!file_.is_open())
+                return;
+            if (!file_.write(data, length))
+            {
+                LOG_SYSERR << "Can't write " << form_.files.back().path;
+                error_ = "Can't save the uploaded file";
+                return;
+            }
+            form_.files.back().size += length;
+            if (md5_)
+            {
+                md5_->update(data, length);
+                sha256_->update(data, length);
+            }
+        }
+
+        void finishPart()
+        {
+            inField_ = false;
+            if (!file_.is_open())
+                return;
+            file_.close();
+            if (file_.fail())
+            {
+                error_ = "Can't save the uploaded file";
+                return;
+            }
+            if (md5_)
+            {
+                form_.files.back().md5 = md5_->hexDigest();
+                form_.files.back().sha256 = sha256_->hexDigest();
+                md5_.reset();
+                sha256_.reset();
+            }
+        }
+
+        void fail(const std::string &message)
+        {
+            removeFiles();
+            finish(std::make_exception_ptr(
+                StreamError(StreamErrorCode::kBadRequest, message)));
+        }
+
+        void finish(std::exception_ptr ex)
+        {
+            auto cb = std::move(formCb_);
+            formCb_ = nullptr;
+            if (ex)
+                cb({}, std::move(ex));
+            else
+                cb(std::move(form_), nullptr);
+        }
+
+        void removeFiles()
+        {
+            if (file_.is_open())
+                file_.close();
+            for (auto &file : form_.files)
+                std::remove(file.path.c_str());
+            form_.files.clear();
+        }
+
+        MultipartStreamParser parser_;
+        MultipartFilePathCallback pathCb_;
+        MultipartFormCallback formCb_;
+        MultipartForm form_;
+        std::ofstream file_;
+        std::optional<Md5Digest> md5_;
+        std::optional<Sha256Digest> sha256_;
+        std::string error_;
+        bool inField_{false};
+        bool computeDigests_;
+    };
+}
+
+RequestStreamPtr xiaoHttp::internal::createRequestStream(
+    const HttpRequestPtr &req)
+{
+    return std::make_shared<RequestStreamImpl>(
+        std::static_pointer_cast<HttpRequestImpl>(req));
+}
+
+RequestStreamReaderPtr RequestStreamReader::newReader(
+    StreamDataCallback dataCb,
+    StreamFinishCallback finishCb)
+{
+    return std::make_shared<DefaultStreamReader>(std::move(dataCb),
+                                                 std::move(finishCb));
+}
+
+RequestStreamReaderPtr RequestStreamReader::newNullReader()
+{
+    return std::make_shared<NullStreamReader>();
+}
+
+RequestStreamReaderPtr RequestStreamReader::newMultipartReader(
+    const HttpRequestPtr &req,
+    MultipartHeaderCallback headerCb,
+    StreamDataCallback dataCb,
+    StreamFinishCallback finishCb)
+{
+    return std::make_shared<MultipartStreamReader>(
+        static_cast<HttpRequestImpl *>(req.get())
+            ->getHeaderView(KnownHeader::ContentType),
+        std::move(headerCb),
+        std::move(dataCb),
+        std::move(finishCb));
+}
+
+RequestStreamReaderPtr RequestStreamReader::newMultipartFileReader(
+    const HttpRequestPtr &req,
+    MultipartFilePathCallback pathCb,
+    MultipartFormCallback formCb,
+    bool computeDigests)
+{
+    return std::make_shared<MultipartFileReader>(
+        static_cast<HttpRequestImpl *>(req.get())
+            ->getHeaderView(KnownHeader::ContentType),
+        std::move(pathCb),
+        std::move(formCb),
+        computeDigests);
+}
@@ -0,0 +1,184 @@
+/**
+ * @file ResponseStream.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-19
+ *
+ *
+ */
+
+#include <xiaoHttp/HttpResponse.h>
+#include "ResponseStreamFlow.h"
+
+using namespace xiaoHttp;
+using namespace xiaoHttp::internal;
+
+void ResponseStreamFlow::install()
+{
+    auto conn = conn_.lock();
+    if (!conn)
+        return;
+    assert(conn->getLoop()->isInLoopThread());
+    setHighWatermarkCallback(kDefaultHighWatermark);
+    std::weak_ptr<ResponseStreamFlow> weakPtr = shared_from_this();
+    conn->setWriteCompleteCallback(
+        [weakPtr](const xiaoNet::TcpConnectionPtr &)
+        {
+            if (auto thisPtr = weakPtr.lock())
+                thisPtr->onWriteComplete();
+        });
+}
+
+void ResponseStreamFlow::setHighWatermarkCallback(size_t highWatermark)
+{
+    std::weak_ptr<ResponseStreamFlow> weakPtr = shared_from_this();
+    if (auto conn = conn_.lock())
+        conn->setHighWaterMarkCallback(
+            [weakPtr](const xiaoNet::TcpConnectionPtr &, size_t)
+            {
+                if (auto thisPtr = weakPtr.lock())
+                    thisPtr->onHighWatermark();
+            },
+            highWatermark);
+}
+
+void ResponseStreamFlow::setWatermarkCallbacks(
+    size_t highWatermark,
+    std::function<void()> onHighWatermark,
+    std::function<void()> onDrain)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        highWatermarkCb_ = std::move(onHighWatermark);
+        drainCb_ = std::move(onDrain);
+    }
+    auto conn = conn_.lock();
+    if (!conn)
+        return;
+    conn->getLoop()->runInLoop(
+        [thisPtr = shared_from_this(), highWatermark]()
+        { thisPtr->setHighWatermarkCallback(highWatermark); });
+}
+
+void ResponseStreamFlow::waitForDrain(std::function<void(bool)> cb)
+{
+    bool open;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open = !closed_;
+        if (open && congested_.load(std::memory_order_acquire))
+        {
+            waiters_.push_back(std::move(cb));
+            return;
+        }
+    }
+    cb(open);
+}
+
+void ResponseStreamFlow::onHighWatermark()
+{
+    std::function<void()> cb;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_ || congested_.exchange(true, std::memory_order_acq_rel))
+            return;
+        cb = highWatermarkCb_;
+    }
+    if (cb)
+        cb();
+}
+
+void ResponseStreamFlow::onWriteComplete()
+{
+    std::function<void()> cb;
+    std::vector<std::function<void(bool)>> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!congested_.exchange(false, std::memory_order_acq_rel))
+            return;
+        cb = drainCb_;
+        waiters.swap(waiters_);
+    }
+    if (cb)
+        cb();
+    for (auto &waiter : waiters)
+        waiter(true);
+}
+
+void ResponseStreamFlow::close()
+{
+    std::vector<std::function<void(bool)>> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_)
+            return;
+        closed_ = true;
+        congested_.store(false, std::memory_order_release);
+        highWatermarkCb_ = nullptr;
+        drainCb_ = nullptr;
+        waiters.swap(waiters_);
+    }
+    for (auto &waiter : waiters)
+        waiter(false);
+    // The connection may serve other responses after the stream
+    if (auto conn = conn_.lock())
+    {
+        conn->getLoop()->runInLoop(
+            [conn]()
+            {
+                conn->setHighWaterMarkCallback(nullptr, 0);
+                conn->setWriteCompleteCallback(nullptr);
+            });
+    }
+}
+
+void ResponseStream::setWatermarkCallbacks(
+    size_t highWatermark,
+    std::function<void()> onHighWatermark,
+    std::function<void()> onDrain)
+{
+    if (flow_)
+        flow_->setWatermarkCallbacks(highWatermark,
+                                     std::move(onHighWatermark),
+                                     std::move(onDrain));
+}
+
+bool ResponseStream::isCongested() const
+{
+    return flow_ && flow_->isCongested();
+}
+
+void ResponseStream::closeFlow()
+{
+    if (flow_)
+    {
+        flow_->close();
+        flow_.reset();
+    }
+}
+
+#ifdef __cpp_impl_coroutine
+bool ResponseStreamSendAwaiter::await_ready()
+{
+    auto sent = stream_.send(data_);
+    data_.clear();
+    if (!sent || !stream_.isCongested())
+    {
+        setValue(sent);
+        return true;
+    }
+    return false;
+}
+
+void ResponseStreamSendAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    auto flow = stream_.flow_;
+    flow->waitForDrain(
+        [this, handle](bool open)
+        {
+            setValue(open);
+            handle.resume();
+        });
+}
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file ResponseStreamFlow.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-19
+ *
+ *
+ */
+
+#pragma once
+
+#include <xiaoNet/net/TcpConnection.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace xiaoHttp
+{
+    namespace internal
+    {
+        /**
+         * @brief The state of the output buffer of a connection that sends
+         * an async stream response.
+         *
+         * The connection reports when its buffer goes over the high water
+         * mark and when it has been written out, the stream is congested
+         * between the two. Every method may be called from any thread.
+         */
+        class ResponseStreamFlow
+            : public std::enable_shared_from_this<ResponseStreamFlow>
+        {
+        public:
+            // Used until the producer sets its own watermark
+            static constexpr size_t kDefaultHighWatermark = 1024 * 1024;
+
+            explicit ResponseStreamFlow(const xiaoNet::TcpConnectionPtr &conn)
+                : conn_(conn)
+            {
+            }
+
+            /// Hook into the connection, in its IO thread.
+            void install();
+
+            void setWatermarkCallbacks(size_t highWatermark,
+                                       std::function<void()> onHighWatermark,
+                                       std::function<void()> onDrain);
+
+            bool isCongested() const
+            {
+                return congested_.load(std::memory_order_acquire);
+            }
+
+            /**
+             * @brief Call @p cb with true once the connection has drained,
+             * right away if it is not congested. It is called with false if
+             * the stream is closed first.
+             */
+            void waitForDrain(std::function<void(bool)> cb);
+
+            /// The stream is closed or the connection is gone.
+            void close();
+
+            /// Called by the connection when its buffer goes over the mark.
+            void onHighWatermark();
+            /// Called by the connection when its buffer is written out.
+            void onWriteComplete();
+
+        private:
+            void setHighWatermarkCallback(size_t highWatermark);
+
+            std::weak_ptr<xiaoNet::TcpConnection> conn_;
+            std::atomic<bool> congested_{false};
+            std::mutex mutex_;
+            bool closed_{false};
+            std::function<void()> highWatermarkCb_;
+            std::function<void()> drainCb_;
+            std::vector<std::function<void(bool)>> waiters_;
+        };
+    }
+}
@@ -0,0 +1,119 @@
+/**
+ * @file StaticAssetStore.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-16
+ *
+ *
+ */
+
+#include "StaticAssetStore.h"
+#include <mutex>
+
+using namespace xiaoHttp;
+
+HttpResponsePtr StaticAssetStore::find(const std::string &key,
+                                       std::string_view tag) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto iter = index_.find(key);
+    if (iter == index_.end())
+        return nullptr;
+    auto &entry = *slots_[iter->second];
+    if (entry.tag != tag || entry.expiry <= Clock::now())
+        return nullptr;
+    entry.referenced.store(true, std::memory_order_relaxed);
+    return entry.response;
+}
+
+bool StaticAssetStore::insert(const std::string &key,
+                              std::string tag,
+                              HttpResponsePtr response,
+                              size_t bytes,
+                              double ttl)
+{
+    if (bytes > budget_)
+        return false;
+    auto entry = std::make_unique<Entry>();
+    entry->key = key;
+    entry->tag = std::move(tag);
+    entry->response = std::move(response);
+    entry->bytes = bytes;
+    entry->expiry =
+        ttl > 0 ? Clock::now() +
+                      std::chrono::duration_cast<Clock::duration>(
+                          std::chrono::duration<double>(ttl))
+                : Clock::time_point::max();
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto iter = index_.find(key);
+    if (iter != index_.end())
+        removeSlot(iter->second);
+    while (used_ + bytes > budget_)
+        evictOne();
+    size_t slot;
+    if (!freeSlots_.empty())
+    {
+        slot = freeSlots_.back();
+        freeSlots_.pop_back();
+        slots_[slot] = std::move(entry);
+    }
+    else
+    {
+        slot = slots_.size();
+        slots_.push_back(std::move(entry));
+    }
+    index_[key] = slot;
+    used_ += bytes;
+    return true;
+}
+
+void StaticAssetStore::erase(const std::string &key)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto iter = index_.find(key);
+    if (iter != index_.end())
+        removeSlot(iter->second);
+}
+
+void StaticAssetStore::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    slots_.clear();
+    freeSlots_.clear();
+    index_.clear();
+    hand_ = 0;
+    used_ = 0;
+}
+
+void StaticAssetStore::removeSlot(size_t slot)
+{
+    auto &entry = slots_[slot];
+    index_.erase(entry->key);
+    used_ -= entry->bytes;
+    entry.reset();
+    freeSlots_.push_back(slot);
+}
+
+// Give the entries used since the last turn of the hand a second chance,
+// expired entries go first. Only called while used_ > 0, so an entry is
+// found within two turns.
+void StaticAssetStore::evictOne()
+{
+    auto now = Clock::now();
+    while (true)
+    {
+        if (hand_ >= slots_.size())
+            hand_ = 0;
+        auto slot = hand_++;
+        auto &entry = slots_[slot];
+        if (!entry)
+            continue;
+        if (entry->expiry > now &&
+            entry->referenced.exchange(false, std::memory_order_relaxed))
+            continue;
+        removeSlot(slot);
+        return;
+    }
+}
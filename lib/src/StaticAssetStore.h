@@ -0,0 +1,104 @@
+/**
+ * @file StaticAssetStore.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-16
+ *
+ *
+ */
+
+#pragma once
+
+#include <xiaoHttp/HttpResponse.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace xiaoHttp
+{
+    /**
+     * @brief The static file responses shared by all IO threads, bounded by
+     * a memory budget.
+     *
+     * The responses are frozen, their header is rendered once and their
+     * body is sent from the same buffer by every thread. A lookup only
+     * takes a shared lock and marks the entry as used, the entries to evict
+     * are chosen with the CLOCK algorithm when a new one does not fit.
+     */
+    class StaticAssetStore
+    {
+    public:
+        explicit StaticAssetStore(size_t budget) : budget_(budget)
+        {
+        }
+
+        /**
+         * @brief Return nullptr if the key is not stored, has expired or was
+         * stored with another tag.
+         *
+         * @param tag Identifies the version of the content, like the size
+         * and the modification time of a file.
+         */
+        HttpResponsePtr find(const std::string &key,
+                             std::string_view tag = {}) const;
+
+        /**
+         * @brief Store a frozen response.
+         *
+         * @param bytes The memory used by the response.
+         * @param ttl The seconds the response is kept, 0 means until it is
+         * evicted or erased.
+         * @return false if the response is larger than the whole budget.
+         */
+        bool insert(const std::string &key,
+                    std::string tag,
+                    HttpResponsePtr response,
+                    size_t bytes,
+                    double ttl);
+
+        void erase(const std::string &key);
+        void clear();
+
+        size_t bytes() const
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            return used_;
+        }
+
+        size_t budget() const
+        {
+            return budget_;
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Entry
+        {
+            std::string key;
+            std::string tag;
+            HttpResponsePtr response;
+            size_t bytes;
+            Clock::time_point expiry; // max() for no expiry
+            mutable std::atomic<bool> referenced{true};
+        };
+
+        void removeSlot(size_t slot);
+        void evictOne();
+
+        mutable std::shared_mutex mutex_;
+        // The clock ring, a removed entry leaves a free slot
+        std::vector<std::unique_ptr<Entry>> slots_;
+        std::vector<size_t> freeSlots_;
+        std::unordered_map<std::string, size_t> index_;
+        size_t hand_{0};
+        size_t used_{0};
+        const size_t budget_;
+    };
+}
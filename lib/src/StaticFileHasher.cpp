@@ -0,0 +1,88 @@
+/**
+ * @file StaticFileHasher.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-24
+ *
+ *
+ */
+
+#include "StaticFileHasher.h"
+#include "Digests.h"
+#include <xiaoHttp/utils/Utilities.h>
+#include <xiaoLog/Logger.h>
+#include <fstream>
+
+using namespace xiaoHttp;
+
+StaticFileHasher::StaticFileHasher(size_t capacity) : hashes_(capacity)
+{
+}
+
+StaticFileHasher::~StaticFileHasher()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cond_.notify_one();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void StaticFileHasher::start()
+{
+    thread_ = std::thread([this] { run(); });
+}
+
+std::string StaticFileHasher::find(const std::string &path,
+                                   const std::string &tag)
+{
+    auto key = path + '\n' + tag;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (auto hash = hashes_.find(key))
+        return *hash;
+    hashes_.insert(key, std::string{});
+    jobs_.push_back({path, std::move(key)});
+    lock.unlock();
+    cond_.notify_one();
+    return {};
+}
+
+void StaticFileHasher::run()
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+        if (stop_)
+            return;
+        auto job = std::move(jobs_.front());
+        jobs_.pop_front();
+        lock.unlock();
+
+        auto hash = hashFile(job.path);
+        if (hash.empty())
+            LOG_ERROR << "Failed to hash " << job.path;
+        lock.lock();
+        hashes_.insert(job.key, std::move(hash));
+    }
+}
+
+std::string StaticFileHasher::hashFile(const std::string &path)
+{
+    std::ifstream infile(utils::toNativePath(path), std::ifstream::binary);
+    if (!infile)
+        return {};
+    std::string buf(64 * 1024, '\0');
+    Sha256Digest digest;
+    while (infile)
+    {
+        infile.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+        digest.update(buf.data(), static_cast<size_t>(infile.gcount()));
+    }
+    if (!infile.eof())
+        return {};
+    return digest.hexDigest();
+}
@@ -0,0 +1,74 @@
+/**
+ * @file StaticFileHasher.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-24
+ *
+ *
+ */
+
+#pragma once
+
+#include "LruCache.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace xiaoHttp
+{
+    /**
+     * @brief Hash the content of static files in the background, for the
+     * content_hash ETags.
+     *
+     * A large file would stall every connection of an IO thread if it was
+     * hashed there. The first request for a version of a file queues it and
+     * gets the file_stat tag, the requests after the job is done get the
+     * hash.
+     */
+    class StaticFileHasher
+    {
+    public:
+        /// @param capacity The number of file versions whose hash is kept.
+        explicit StaticFileHasher(size_t capacity);
+        ~StaticFileHasher();
+
+        StaticFileHasher(const StaticFileHasher &) = delete;
+        StaticFileHasher &operator=(const StaticFileHasher &) = delete;
+
+        /// Start the worker thread.
+        void start();
+
+        /**
+         * @brief Return the SHA-256 of the file in hex if it is ready, or
+         * an empty string after queueing the job.
+         *
+         * Thread-safe, it does not touch the disk.
+         * @param tag Identifies the version of the file.
+         */
+        std::string find(const std::string &path, const std::string &tag);
+
+        /// Hash a file piece by piece, an empty string if it can't be read.
+        static std::string hashFile(const std::string &path);
+
+    private:
+        struct Job
+        {
+            std::string path;
+            std::string key;
+        };
+
+        void run();
+
+        std::mutex mutex_;
+        std::condition_variable cond_;
+        std::deque<Job> jobs_;
+        // path and tag -> hash, empty while the job is queued or if it
+        // failed
+        LruCache<std::string> hashes_;
+        bool stop_{false};
+        std::thread thread_;
+    };
+}
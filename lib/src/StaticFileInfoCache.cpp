@@ -0,0 +1,91 @@
+/**
+ * @file StaticFileInfoCache.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-14
+ *
+ *
+ */
+
+#include "StaticFileInfoCache.h"
+#include <xiaoHttp/utils/Utilities.h>
+#include <xiaoLog/Logger.h>
+#include <sys/stat.h>
+#include <ctime>
+
+using namespace xiaoHttp;
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+using StatType = struct _stati64;
+#else
+using StatType = struct stat;
+#endif
+
+// std::filesystem::file_time_type::clock::to_time_t still not
+// implemented by M$, even in c++20, so keep calls to stat()
+static bool statFile(const std::string &path, StatType &fileStat)
+{
+    return stat(utils::toNativePath(path).c_str(), &fileStat) == 0;
+}
+
+static bool isRegularFile(const std::string &path)
+{
+    StatType fileStat;
+    return statFile(path, fileStat) && S_ISREG(fileStat.st_mode);
+}
+
+std::shared_ptr<StaticFileInfo> StaticFileInfoCache::load(
+    const std::string &path,
+    bool brStatic,
+    bool gzipStatic)
+{
+    auto info = std::make_shared<StaticFileInfo>();
+    StatType fileStat;
+    if (!statFile(path, fileStat))
+        return info;
+    if (S_ISDIR(fileStat.st_mode))
+    {
+        info->type_ = StaticFileInfo::Type::kDirectory;
+        return info;
+    }
+    if (!S_ISREG(fileStat.st_mode))
+    {
+        info->type_ = StaticFileInfo::Type::kOther;
+        return info;
+    }
+    info->type_ = StaticFileInfo::Type::kRegular;
+    info->fileSize_ = fileStat.st_size;
+    info->inode_ = static_cast<uint64_t>(fileStat.st_ino);
+    info->modifiedTime_ = fileStat.st_mtime;
+    LOG_TRACE << "last modify time:" << fileStat.st_mtime;
+    struct tm modifiedTime;
+#ifdef _WIN32
+    gmtime_s(&modifiedTime, &fileStat.st_mtime);
+#else
+    gmtime_r(&fileStat.st_mtime, &modifiedTime);
+#endif
+    std::string &timeStr = info->modifiedTimeStr_;
+    timeStr.resize(64);
+    size_t len = strftime((char *)timeStr.data(),
+                          timeStr.size(),
+                          "%a, %d %b %Y %H:%M:%S GMT",
+                          &modifiedTime);
+    timeStr.resize(len);
+    // Two more system calls per file, only made when they are used
+    info->hasBrFile_ = brStatic && isRegularFile(path + ".br");
+    info->hasGzipFile_ = gzipStatic && isRegularFile(path + ".gz");
+    return info;
+}
+
+StaticFileInfoPtr StaticFileInfoCache::get(const std::string &path)
+{
+    auto now = std::chrono::steady_clock::now();
+    auto cached = cache_.find(path);
+    if (cached && (*cached)->expiry_ > now)
+        return *cached;
+    auto info = load(path, brStatic_, gzipStatic_);
+    info->expiry_ = now + ttl_;
+    cache_.insert(path, info);
+    return info;
+}
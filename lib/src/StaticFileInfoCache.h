@@ -0,0 +1,108 @@
+/**
+ * @file StaticFileInfoCache.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-14
+ *
+ *
+ */
+
+#pragma once
+
+#include "LruCache.h"
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <string>
+
+namespace xiaoHttp
+{
+    // What stat() told about a static file and its precompressed siblings
+    struct StaticFileInfo
+    {
+        enum class Type : uint8_t
+        {
+            kNone,
+            kRegular,
+            kDirectory,
+            kOther
+        };
+
+        Type type_{Type::kNone};
+        size_t fileSize_{0};
+        uint64_t inode_{0};
+        time_t modifiedTime_{0};
+        std::string modifiedTimeStr_;
+        // path + ".br" is a regular file, only looked up for br_static
+        bool hasBrFile_{false};
+        // path + ".gz" is a regular file, only looked up for gzip_static
+        bool hasGzipFile_{false};
+        std::chrono::steady_clock::time_point expiry_;
+
+        bool isRegular() const
+        {
+            return type_ == Type::kRegular;
+        }
+
+        bool isDirectory() const
+        {
+            return type_ == Type::kDirectory;
+        }
+
+        bool exists() const
+        {
+            return type_ != Type::kNone;
+        }
+    };
+
+    using StaticFileInfoPtr = std::shared_ptr<const StaticFileInfo>;
+
+    /**
+     * @brief A bounded cache of StaticFileInfo keyed by file path.
+     *
+     * It is used through IOThreadStorage, so a hit costs neither a lock nor
+     * a system call. Missing files are cached too. An entry is trusted for
+     * ttl, so changes on disk are seen after at most ttl.
+     */
+    class StaticFileInfoCache
+    {
+    public:
+        /// @param brStatic, gzipStatic Look for the precompressed siblings.
+        StaticFileInfoCache(size_t capacity,
+                            std::chrono::steady_clock::duration ttl,
+                            bool brStatic,
+                            bool gzipStatic)
+            : cache_(capacity),
+              ttl_(ttl),
+              brStatic_(brStatic),
+              gzipStatic_(gzipStatic)
+        {
+        }
+
+        /// Never returns nullptr.
+        StaticFileInfoPtr get(const std::string &path);
+
+        /// Forget a path, it is looked up again on the next request.
+        void erase(const std::string &path)
+        {
+            cache_.erase(path);
+        }
+
+        void clear()
+        {
+            cache_.clear();
+        }
+
+        /// Stat the file and the siblings asked for now, without any cache.
+        static std::shared_ptr<StaticFileInfo> load(const std::string &path,
+                                                    bool brStatic,
+                                                    bool gzipStatic);
+
+    private:
+        LruCache<StaticFileInfoPtr> cache_;
+        std::chrono::steady_clock::duration ttl_;
+        bool brStatic_;
+        bool gzipStatic_;
+    };
+}
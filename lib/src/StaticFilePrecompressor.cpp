@@ -0,0 +1,173 @@
+/**
+ * @file StaticFilePrecompressor.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-17
+ *
+ *
+ */
+
+#include "StaticFilePrecompressor.h"
+#include <xiaoHttp/utils/Utilities.h>
+#include <xiaoLog/Logger.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+
+using namespace xiaoHttp;
+
+// Files are read and compressed in pieces of this size
+static constexpr size_t kReadChunkSize = 64 * 1024;
+
+StaticFilePrecompressor::StaticFilePrecompressor(std::string cacheDir,
+                                                 size_t capacity)
+    : cacheDir_(std::move(cacheDir)), states_(capacity)
+{
+}
+
+StaticFilePrecompressor::~StaticFilePrecompressor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cond_.notify_one();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+bool StaticFilePrecompressor::start()
+{
+    if (utils::createPath(cacheDir_) == -1)
+    {
+        LOG_ERROR << "Can not create the precompression cache directory "
+                  << cacheDir_;
+        return false;
+    }
+    thread_ = std::thread([this] { run(); });
+    return true;
+}
+
+std::string StaticFilePrecompressor::targetPath(const std::string &path,
+                                                size_t fileSize,
+                                                time_t modifiedTime,
+                                                ContentCoding coding) const
+{
+    // The name of the file is kept to make the directory readable, the
+    // hash of the whole path tells files of the same name apart.
+    auto slash = path.rfind('/');
+    auto name = slash == std::string::npos ? path : path.substr(slash + 1);
+    char buf[64];
+    snprintf(buf,
+             sizeof(buf),
+             "-%zx-%zx-%llx.",
+             std::hash<std::string>{}(path),
+             fileSize,
+             static_cast<unsigned long long>(modifiedTime));
+    std::string target = cacheDir_;
+    if (target.back() != '/')
+        target.append(1, '/');
+    target.append(name).append(buf);
+    target.append(coding == ContentCoding::kBrotli ? "br" : "gz");
+    return target;
+}
+
+std::string StaticFilePrecompressor::find(const std::string &path,
+                                          size_t fileSize,
+                                          time_t modifiedTime,
+                                          ContentCoding coding)
+{
+    if (!HttpCompressor::isSupported(coding) || coding == ContentCoding::kZstd)
+        return {};
+    auto target = targetPath(path, fileSize, modifiedTime, coding);
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (auto state = states_.find(target))
+        return *state == State::kReady ? target : std::string{};
+    states_.insert(target, State::kQueued);
+    jobs_.push_back({path, std::move(target), coding});
+    lock.unlock();
+    cond_.notify_one();
+    return {};
+}
+
+void StaticFilePrecompressor::run()
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+        if (stop_)
+            return;
+        auto job = std::move(jobs_.front());
+        jobs_.pop_front();
+        lock.unlock();
+
+        // A file compressed by a previous run is used as it is
+        std::error_code err;
+        auto ok = std::filesystem::is_regular_file(
+                      utils::toNativePath(job.target), err) ||
+                  compressFile(job);
+        lock.lock();
+        states_.insert(job.target, ok ? State::kReady : State::kFailed);
+    }
+}
+
+bool StaticFilePrecompressor::compressFile(const Job &job)
+{
+    std::ifstream infile(utils::toNativePath(job.source),
+                         std::ifstream::binary);
+    if (!infile)
+        return false;
+    // Written aside and renamed, a reader never sees a partial file
+    auto tmpPath = job.target + ".tmp";
+    std::ofstream outfile(utils::toNativePath(tmpPath),
+                          std::ofstream::binary | std::ofstream::trunc);
+    if (!outfile)
+    {
+        LOG_ERROR << "Can not create " << tmpPath;
+        return false;
+    }
+    auto compressor = HttpCompressor::acquire(
+        job.coding,
+        job.coding == ContentCoding::kBrotli ? kBrotliLevel : kGzipLevel);
+    if (!compressor)
+        return false;
+    std::string in(kReadChunkSize, '\0');
+    std::string out;
+    bool ok = true;
+    while (ok)
+    {
+        infile.read(in.data(), static_cast<std::streamsize>(in.size()));
+        auto len = static_cast<size_t>(infile.gcount());
+        auto last = !infile;
+        out.clear();
+        ok = compressor->compress(in.data(),
+                                  len,
+                                  last ? StreamCompressor::Flush::kFinish
+                                       : StreamCompressor::Flush::kNone,
+                                  out) &&
+             outfile.write(out.data(), static_cast<std::streamsize>(out.size()));
+        if (last)
+            break;
+    }
+    ok = ok && infile.eof() && outfile.flush();
+    outfile.close();
+    std::error_code err;
+    if (ok)
+    {
+        std::filesystem::rename(utils::toNativePath(tmpPath),
+                                utils::toNativePath(job.target),
+                                err);
+        ok = !err;
+    }
+    if (!ok)
+    {
+        LOG_ERROR << "Failed to precompress " << job.source;
+        std::filesystem::remove(utils::toNativePath(tmpPath), err);
+        return false;
+    }
+    LOG_TRACE << "Precompressed " << job.source << " to " << job.target;
+    return true;
+}
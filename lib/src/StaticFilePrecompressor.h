@@ -0,0 +1,95 @@
+/**
+ * @file StaticFilePrecompressor.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-17
+ *
+ *
+ */
+
+#pragma once
+
+#include "HttpCompressor.h"
+#include "LruCache.h"
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace xiaoHttp
+{
+    /**
+     * @brief Compress static files in the background and keep the results
+     * in a cache directory.
+     *
+     * The first request for a file queues it and is served without the
+     * precompressed version, the requests after the job is done are served
+     * from the cache directory. A cached file is named after the size and
+     * the modification time of the original one, so a changed file is
+     * compressed again and its old versions are never served.
+     */
+    class StaticFilePrecompressor
+    {
+    public:
+        /// The levels used, the files are compressed once so the best ones.
+        static constexpr int kGzipLevel = 9;
+        static constexpr int kBrotliLevel = 11;
+
+        /// @param capacity The number of file versions whose state is kept.
+        StaticFilePrecompressor(std::string cacheDir, size_t capacity);
+        ~StaticFilePrecompressor();
+
+        StaticFilePrecompressor(const StaticFilePrecompressor &) = delete;
+        StaticFilePrecompressor &operator=(const StaticFilePrecompressor &) =
+            delete;
+
+        /// Create the cache directory and start the worker thread.
+        bool start();
+
+        /**
+         * @brief Return the path of the compressed file if it is ready, or
+         * an empty string after queueing the job.
+         *
+         * Thread-safe, it does not touch the disk.
+         */
+        std::string find(const std::string &path,
+                         size_t fileSize,
+                         time_t modifiedTime,
+                         ContentCoding coding);
+
+    private:
+        struct Job
+        {
+            std::string source;
+            std::string target;
+            ContentCoding coding;
+        };
+
+        enum class State : uint8_t
+        {
+            kQueued,
+            kReady,
+            kFailed
+        };
+
+        std::string targetPath(const std::string &path,
+                               size_t fileSize,
+                               time_t modifiedTime,
+                               ContentCoding coding) const;
+        void run();
+        static bool compressFile(const Job &job);
+
+        const std::string cacheDir_;
+        std::mutex mutex_;
+        std::condition_variable cond_;
+        std::deque<Job> jobs_;
+        // target path -> state, a version that was evicted is looked up on
+        // the disk again by the worker
+        LruCache<State> states_;
+        bool stop_{false};
+        std::thread thread_;
+    };
+}
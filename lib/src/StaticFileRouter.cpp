@@ -9,26 +9,39 @@
  */
 
 #include "StaticFileRouter.h"
+#include "HttpCompressionPolicy.h"
+#include "HttpResponseCompression.h"
+#include <xiaoHttp/utils/Utilities.h>
+#include <fstream>
 
 using namespace xiaoHttp;
 
 void StaticFileRouter::init(const std::vector<xiaoNet::EventLoop *> &ioLoops)
 {
-    // Max timeout up to about 70 days;
-    staticFilesCacheMap_ = std::make_unique<
-        IOThreadStorage<std::unique_ptr<CacheMap<std::string, char>>>>();
-    staticFilesCacheMap_->init(
-        [&ioLoops](std::unique_ptr<CacheMap<std::string, char>> &mapPtr,
-                   size_t i)
-        {
-            assert(i == ioLoops[i]->index());
-            mapPtr = std::make_unique<CacheMap<std::string, char>>(ioLoops[i],
-                                                                   1.0,
-                                                                   4,
-                                                                   50);
-        });
-    staticFilesCache_ = std::make_unique<
-        IOThreadStorage<std::unordered_map<std::string, HttpResponsePtr>>>();
+    if (assetStoreSize_ > 0 && staticFilesCacheTime_ >= 0)
+        assetStore_ = std::make_unique<StaticAssetStore>(assetStoreSize_);
+    if (fileInfoCacheSize_ > 0)
+    {
+        fileInfoCache_ = std::make_unique<IOThreadStorage<StaticFileInfoCache>>(
+            fileInfoCacheSize_,
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(fileInfoCacheTtl_)),
+            brStaticFlag_,
+            gzipStaticFlag_);
+    }
+    if (etagMode_ == ETagMode::kContentHash)
+    {
+        hasher_ = std::make_unique<StaticFileHasher>(4096);
+        hasher_->start();
+    }
+    if (!precompressionDir_.empty())
+    {
+        precompressor_ =
+            std::make_unique<StaticFilePrecompressor>(precompressionDir_,
+                                                      4096);
+        if (!precompressor_->start())
+            precompressor_.reset();
+    }
     ioLocationsPtr_ =
         std::make_shared<IOThreadStorage<std::vector<Location>>>();
     for (auto *loop : ioLoops)
@@ -39,12 +52,219 @@ void StaticFileRouter::init(const std::vector<xiaoNet::EventLoop *> &ioLoops)
                 **ioLocationsPtr = locations;
             });
     }
+    if (watchFiles_)
+    {
+        watcher_ = std::make_unique<StaticFileWatcher>(
+            [this, ioLoops](const std::string &path)
+            {
+                // The responses are shared, the metadata is per thread
+                if (assetStore_)
+                {
+                    if (path.empty())
+                        assetStore_->clear();
+                    else
+                        assetStore_->erase(path);
+                }
+                for (auto *loop : ioLoops)
+                {
+                    loop->queueInLoop([this, path] { invalidate(path); });
+                }
+            });
+        watcher_->addRoot(HttpAppFrameworkImpl::instance().getDocumentRoot());
+        for (auto const &location : locations_)
+        {
+            watcher_->addRoot(realLocationOf(location));
+        }
+        if (!watcher_->start())
+            watcher_.reset();
+    }
+}
+
+std::string StaticFileRouter::realLocationOf(const Location &location)
+{
+    std::string realLocation;
+    if (!location.alias_.empty())
+    {
+        if (location.alias_[0] == '/')
+        {
+            realLocation = location.alias_;
+        }
+        else
+        {
+            realLocation = HttpAppFrameworkImpl::instance().getDocumentRoot() +
+                           location.alias_;
+        }
+    }
+    else
+    {
+        realLocation = HttpAppFrameworkImpl::instance().getDocumentRoot() +
+                       location.uriPrefix_;
+    }
+    if (realLocation[realLocation.length() - 1] != '/')
+    {
+        realLocation.append(1, '/');
+    }
+    return realLocation;
+}
+
+// Cached entries are keyed by path, "a//b" is made "a/b" so that the keys
+// match the paths reported by the file watcher.
+static void collapseSlashes(std::string &path)
+{
+    if (path.find("//") == std::string::npos)
+        return;
+    auto last = std::unique(path.begin(),
+                            path.end(),
+                            [](char a, char b) { return a == '/' && b == '/'; });
+    path.erase(last, path.end());
+}
+
+// Memory of a stored response besides its body: the rendered header, the
+// key and the bookkeeping of the store.
+static constexpr size_t kAssetOverhead = 1024;
+
+// The inode, the size and the modification time identify the content, a
+// precompressed sibling is another representation of it.
+static std::string fileStatTag(const StaticFileInfo &info,
+                               std::string_view encoding)
+{
+    char buf[64];
+    auto len = snprintf(buf,
+                        sizeof(buf),
+                        "%llx-%zx-%llx",
+                        static_cast<unsigned long long>(info.inode_),
+                        info.fileSize_,
+                        static_cast<unsigned long long>(info.modifiedTime_));
+    std::string tag(buf, len);
+    if (!encoding.empty())
+    {
+        tag.append(1, '-').append(encoding);
+    }
+    return tag;
+}
+
+// Whether the comma separated list of entity-tags of an If-Match or
+// If-None-Match header holds the etag, with the strong or the weak
+// comparison of rfc9110-8.8.3.2. "*" matches any current representation.
+static bool etagListMatches(std::string_view list,
+                            std::string_view etag,
+                            bool strong)
+{
+    if (list == "*")
+        return true;
+    if (etag.empty())
+        return false;
+    size_t pos = 0;
+    while (pos < list.size())
+    {
+        auto c = list[pos];
+        if (c == ' ' || c == '\t' || c == ',')
+        {
+            ++pos;
+            continue;
+        }
+        bool weak = list.substr(pos, 2) == "W/";
+        if (weak)
+            pos += 2;
+        if (pos >= list.size() || list[pos] != '"')
+            return false;
+        auto end = list.find('"', pos + 1);
+        if (end == std::string_view::npos)
+            return false;
+        if (!(strong && weak) && list.substr(pos, end + 1 - pos) == etag)
+            return true;
+        pos = end + 1;
+    }
+    return false;
+}
+
+// A multipart/byteranges response, rfc9110-14.6. The parts are sent from
+// the file with sendfile, only their boundaries and headers are in memory.
+static HttpResponsePtr newMultiRangeResponse(
+    const std::string &filePath,
+    const std::vector<FileRange> &ranges,
+    size_t fileSize,
+    std::string_view mime)
+{
+    auto boundary = utils::genRandomString(32);
+    std::vector<HttpResponseImpl::SendfilePart> parts;
+    parts.reserve(ranges.size());
+    char buf[128];
+    for (auto const &range : ranges)
+    {
+        std::string head;
+        if (!parts.empty())
+            head.append("\r\n");
+        head.append("--").append(boundary).append("\r\n");
+        if (!mime.empty())
+            head.append("content-type: ").append(mime).append("\r\n");
+        auto len = snprintf(buf,
+                            sizeof(buf),
+                            "content-range: bytes %zu-%zu/%zu\r\n\r\n",
+                            range.start,
+                            range.end - 1,
+                            fileSize);
+        head.append(buf, len);
+        parts.push_back(
+            {std::move(head), {range.start, range.end - range.start}});
+    }
+    auto resp = std::make_shared<HttpResponseImpl>();
+    resp->setStatusCode(k206PartialContent);
+    resp->setContentTypeCodeAndCustomString(
+        CT_CUSTOM, "multipart/byteranges; boundary=" + boundary);
+    resp->setSendfile(filePath);
+    resp->setSendfileParts(std::move(parts), "\r\n--" + boundary + "--\r\n");
+    return resp;
+}
+
+// Read a regular file of at most maxSize bytes, return false if it is larger
+// or can not be read.
+static bool readSmallFile(const std::string &path,
+                          size_t maxSize,
+                          std::string &content)
+{
+    std::ifstream infile(utils::toNativePath(path), std::ifstream::binary);
+    if (!infile)
+        return false;
+    infile.seekg(0, std::ios::end);
+    auto size = infile.tellg();
+    if (size < 0 || static_cast<size_t>(size) > maxSize)
+        return false;
+    content.resize(static_cast<size_t>(size));
+    infile.seekg(0, std::ios::beg);
+    return static_cast<bool>(
+        infile.read(content.data(), static_cast<std::streamsize>(size)));
+}
+
+void StaticFileRouter::invalidate(const std::string &path)
+{
+    if (!fileInfoCache_)
+        return;
+    auto &infos = fileInfoCache_->getThreadData();
+    if (path.empty())
+    {
+        infos.clear();
+        return;
+    }
+    LOG_TRACE << "Invalidate " << path;
+    infos.erase(path);
+    // The metadata of a file tells whether it has precompressed siblings
+    std::string_view sv(path);
+    if (sv.size() > 3 && (sv.substr(sv.size() - 3) == ".br" ||
+                          sv.substr(sv.size() - 3) == ".gz"))
+    {
+        infos.erase(path.substr(0, path.size() - 3));
+    }
 }
 
 void StaticFileRouter::reset()
 {
-    staticFilesCacheMap_.reset();
-    staticFilesCache_.reset();
+    // Stop the watcher first, it posts invalidations to the IO threads
+    watcher_.reset();
+    assetStore_.reset();
+    precompressor_.reset();
+    hasher_.reset();
+    fileInfoCache_.reset();
     ioLocationsPtr_.reset();
     locations_.clear();
 }
@@ -90,30 +310,7 @@ void StaticFileRouter::route(
         auto &URI = location.uriPrefix_;
         if (location.realLocation_.empty())
         {
-            if (!location.alias_.empty())
-            {
-                if (location.alias_[0] == '/')
-                {
-                    location.realLocation_ = location.alias_;
-                }
-                else
-                {
-                    location.realLocation_ =
-                        HttpAppFrameworkImpl::instance().getDocumentRoot() +
-                        location.alias_;
-                }
-            }
-            else
-            {
-                location.realLocation_ =
-                    HttpAppFrameworkImpl::instance().getDocumentRoot() +
-                    location.uriPrefix_;
-            }
-            if (location.realLocation_[location.realLocation_.length() - 1] !=
-                '/')
-            {
-                location.realLocation_.append(1, '/');
-            }
+            location.realLocation_ = realLocationOf(location);
             if (!location.isCaseSensitive_)
             {
                 std::transform(URI.begin(),
@@ -141,14 +338,13 @@ void StaticFileRouter::route(
             std::string filePath =
                 location.realLocation_ +
                 std::string{restOfThePath.data(), restOfThePath.length()};
-            std::filesystem::path fsFilePath(utils::toNativePath(filePath));
-            std::error_code err;
-            if (!std::filesystem::exists(fsFilePath, err))
+            auto info = fileInfo(filePath);
+            if (!info->exists())
             {
                 defaultHandler_(req, std::move(callback));
                 return;
             }
-            if (std::filesystem::is_directory(fsFilePath, err))
+            if (info->isDirectory())
             {
                 // Check if path is eligible for an implicit index.html
                 if (implicitPageEnable_)
@@ -188,6 +384,7 @@ void StaticFileRouter::route(
                 }
             }
 
+            collapseSlashes(filePath);
             if (location.filters_.empty())
             {
                 sendStaticFileResponse(filePath,
@@ -227,16 +424,17 @@ void StaticFileRouter::route(
     }
     std::string directoryPath =
         HttpAppFrameworkImpl::instance().getDocumentRoot() + path;
-    std::filesystem::path fsDirectoryPath(utils::toNativePath(directoryPath));
-    std::error_code err;
-    if (std::filesystem::exists(fsDirectoryPath, err))
+    collapseSlashes(directoryPath);
+    auto info = fileInfo(directoryPath);
+    if (info->exists())
     {
-        if (std::filesystem::is_directory(fsDirectoryPath, err))
+        if (info->isDirectory())
         {
             // Check if path is eligible for an implicit index.html
             if (implicitPageEnable_)
             {
                 std::string filePath = directoryPath + "/" + implicitPage_;
+                collapseSlashes(filePath);
                 sendStaticFileResponse(filePath, req, std::move(callback), "");
                 return;
             }
@@ -268,48 +466,6 @@ void StaticFileRouter::route(
     defaultHandler_(req, std::move(callback));
 }
 
-// Expand this struct as you need, nothing to worry about
-struct FileStat
-{
-    size_t fileSize_;
-    struct tm modifiedTime_;
-    std::string modifiedTimeStr_;
-};
-
-// A wrapper to call stat()
-// std::filesystem::file_time_type::clock::to_time_t still not
-// implemented by M$, even in c++20, so keep calls to stat()
-static bool getFileStat(const std::string &filePath, FileStat &myStat)
-{
-#if defined(_WIN32) && !defined(__MINGW32__)
-    struct _stati64 fileStat;
-#else  // _WIN32
-    struct stat fileStat;
-#endif // _WIN32
-    if (stat(utils::toNativePath(filePath).c_str(), &fileStat) == 0 &&
-        S_ISREG(fileStat.st_mode))
-    {
-        LOG_TRACE << "last modify time:" << fileStat.st_mtime;
-#ifdef _WIN32
-        gmtime_s(&myStat.modifiedTime_, &fileStat.st_mtime);
-#else
-        gmtime_r(&fileStat.st_mtime, &myStat.modifiedTime_);
-#endif
-        std::string &timeStr = myStat.modifiedTimeStr_;
-        timeStr.resize(64);
-        size_t len = strftime((char *)timeStr.data(),
-                              timeStr.size(),
-                              "%a, %d %b %Y %H:%M:%S GMT",
-                              &myStat.modifiedTime_);
-        timeStr.resize(len);
-
-        myStat.fileSize_ = fileStat.st_size;
-        return true;
-    }
-
-    return false;
-}
-
 void StaticFileRouter::sendStaticFileResponse(
     const std::string &filePath,
     const HttpRequestImplPtr &req,
@@ -321,43 +477,122 @@ void StaticFileRouter::sendStaticFileResponse(
         callback(app().getCustomErrorHandler()(k405MethodNotAllowed, req));
         return;
     }
+    auto info = fileInfo(filePath);
+    if (!info->isRegular())
+    {
+        defaultHandler_(req, std::move(callback));
+        return;
+    }
 
-    FileStat fileStat;
-    bool fileExists = false;
-    const std::string &rangeStr = req->getHeaderBy("range");
-    if (enableRange_ && !rangeStr.empty())
+    // Find compressed file first. A range is always taken from the file
+    // itself.
+    auto rangeStr = req->getHeaderView(KnownHeader::Range);
+    bool isRange = enableRange_ && !rangeStr.empty();
+    std::string_view encoding;
+    std::string servedPath;
+    auto acceptEncoding = req->getHeaderView(KnownHeader::AcceptEncoding);
+    if (isRange)
     {
-        if (!getFileStat(filePath, fileStat))
-        {
-            defaultHandler_(req, std::move(callback));
-            return;
-        }
-        fileExists = true;
-        // Check last modified time, rfc2616-14.25
-        // If-Modified-Since: Mon, 15 Oct 2018 06:26:33 GMT
-        // According to rfc 7233-3.1, preconditions must be evaluated before
-        const std::string &modiStr = req->getHeaderBy("if-modified-since");
-        if (enableLastModify_ && modiStr == fileStat.modifiedTimeStr_)
-        {
-            LOG_TRACE << "Not modified!";
-            std::shared_ptr<HttpResponseImpl> resp =
-                std::make_shared<HttpResponseImpl>();
-            resp->setStatusCode(k304NotModified);
-            resp->setContentTypeCode(CT_NONE);
-            callback(resp);
-            return;
-        }
-        // Check If-Range precondition
-        const std::string &ifRange = req->getHeaderBy("if-range");
-        if (ifRange.empty() || ifRange == fileStat.modifiedTimeStr_)
+        servedPath = filePath;
+    }
+    else if (brStaticFlag_ && info->hasBrFile_ &&
+             HttpResponseCompression::qValue(acceptEncoding,
+                                             ContentCoding::kBrotli) > 0)
+    {
+        encoding = "br";
+        servedPath = filePath + ".br";
+    }
+    else if (gzipStaticFlag_ && info->hasGzipFile_ &&
+             HttpResponseCompression::qValue(acceptEncoding,
+                                             ContentCoding::kGzip) > 0)
+    {
+        encoding = "gzip";
+        servedPath = filePath + ".gz";
+    }
+    else
+    {
+        servedPath =
+            precompressedFile(filePath, *info, acceptEncoding, encoding);
+        if (servedPath.empty())
+            servedPath = filePath;
+    }
+
+    // find cached response, it is stale if the file has changed since
+    auto tag = fileStatTag(*info, encoding);
+    HttpResponsePtr cachedResp;
+    if (assetStore_)
+        cachedResp = assetStore_->find(servedPath, tag);
+    // A response is not kept while its content hash is being computed,
+    // it would hold the fallback tag for as long as it is cached
+    bool etagIsFinal = true;
+    auto etag = cachedResp ? static_cast<HttpResponseImpl *>(cachedResp.get())
+                                 ->getHeaderBy("etag")
+                           : makeETag(servedPath, tag, etagIsFinal);
+
+    // Preconditions are evaluated in the order of rfc9110-13.2.2
+    auto ifMatch = req->getHeaderView(KnownHeader::IfMatch);
+    if (!ifMatch.empty() && !etagListMatches(ifMatch, etag, true))
+    {
+        callback(app().getCustomErrorHandler()(k412PreconditionFailed, req));
+        return;
+    }
+    // If-Modified-Since is ignored when If-None-Match is present
+    auto ifNoneMatch = req->getHeaderView(KnownHeader::IfNoneMatch);
+    if (!ifNoneMatch.empty()
+            ? etagListMatches(ifNoneMatch, etag, false)
+            : enableLastModify_ &&
+                  req->getHeaderView(KnownHeader::IfModifiedSince) ==
+                      info->modifiedTimeStr_)
+    {
+        LOG_TRACE << "not Modified!";
+        std::shared_ptr<HttpResponseImpl> resp =
+            std::make_shared<HttpResponseImpl>();
+        resp->setStatusCode(k304NotModified);
+        resp->setContentTypeCode(CT_NONE);
+        if (!etag.empty())
+            resp->addHeader("ETag", etag);
+        if (hasEncodedVariants(filePath, *info))
+            HttpResponseCompression::addVaryAcceptEncoding(resp.get());
+        callback(resp);
+        return;
+    }
+
+    if (isRange)
+    {
+        auto &fileStat = *info;
+        // If-Range holds a strong entity-tag or a date, rfc9110-13.1.5
+        auto ifRange = req->getHeaderView(KnownHeader::IfRange);
+        bool isETag = !ifRange.empty() &&
+                      (ifRange[0] == '"' || ifRange.substr(0, 2) == "W/");
+        if (ifRange.empty() ||
+            (isETag ? !etag.empty() && ifRange == etag
+                    : ifRange == fileStat.modifiedTimeStr_))
         {
             std::vector<FileRange> ranges;
             switch (parseRangeHeader(rangeStr, fileStat.fileSize_, ranges))
             {
-            // TODO: support only single range now
-            // Contributions are welcomed.
-            case FileRangeParseResult::SinglePart:
             case FileRangeParseResult::MultiPart:
+            {
+                auto ct = fileNameToContentTypeAndMime(filePath);
+                auto resp = newMultiRangeResponse(filePath,
+                                                  ranges,
+                                                  fileStat.fileSize_,
+                                                  ct.second);
+                if (!fileStat.modifiedTimeStr_.empty())
+                {
+                    resp->addHeader("Last-Modified",
+                                    fileStat.modifiedTimeStr_);
+                    resp->addHeader("Expires",
+                                    "Thu, 01 Jan 1970 00:00:00 GMT");
+                }
+                if (!etag.empty())
+                {
+                    resp->addHeader("ETag", etag);
+                }
+                callback(resp);
+                return;
+            }
+            case FileRangeParseResult::SinglePart:
             {
                 auto firstRange = ranges.front();
                 auto ct = fileNameToContentTypeAndMime(filePath);
@@ -378,6 +613,10 @@ void StaticFileRouter::sendStaticFileResponse(
                     resp->addHeader("Expires",
                                     "Thu, 01 Jan 1970 00:00:00 GMT");
                 }
+                if (!etag.empty())
+                {
+                    resp->addHeader("ETag", etag);
+                }
                 callback(resp);
                 return;
             }
@@ -411,155 +650,168 @@ void StaticFileRouter::sendStaticFileResponse(
         }
     }
 
-    // find cached response
-    HttpResponsePtr cachedResp;
-    auto &cacheMap = staticFilesCache_->getThreadData();
-    auto iter = cacheMap.find(filePath);
-    if (iter != cacheMap.end())
-    {
-        cachedResp = iter->second;
-    }
-
-    if (enableLastModify_)
-    {
-        if (cachedResp)
-        {
-            if (static_cast<HttpResponseImpl *>(cachedResp.get())
-                    ->getHeaderBy("last-modified") ==
-                req->getHeaderBy("if-modified-since"))
-            {
-                std::shared_ptr<HttpResponseImpl> resp =
-                    std::make_shared<HttpResponseImpl>();
-                resp->setStatusCode(k304NotModified);
-                resp->setContentTypeCode(CT_NONE);
-                callback(resp);
-                return;
-            }
-        }
-        else
-        {
-            LOG_TRACE << "enabled LastModify";
-            if (!fileExists && !getFileStat(filePath, fileStat))
-            {
-                defaultHandler_(req, std::move(callback));
-                return;
-            }
-            fileExists = true;
-            const std::string &modiStr = req->getHeaderBy("if-modified-since");
-            if (modiStr == fileStat.modifiedTimeStr_)
-            {
-                LOG_TRACE << "not Modified!";
-                std::shared_ptr<HttpResponseImpl> resp =
-                    std::make_shared<HttpResponseImpl>();
-                resp->setStatusCode(k304NotModified);
-                resp->setContentTypeCode(CT_NONE);
-                callback(resp);
-                return;
-            }
-        }
-    }
     if (cachedResp)
     {
         LOG_TRACE << "Using file cache";
         callback(cachedResp);
         return;
     }
-    // Check existence
-    if (!fileExists)
+    auto resp = newAssetResponse(
+        filePath, servedPath, *info, encoding, defaultContentType, req);
+    if (resp->statusCode() != k404NotFound)
     {
-        std::filesystem::path fsFilePath(utils::toNativePath(filePath));
-        std::error_code err;
-        if (!std::filesystem::exists(fsFilePath, err) ||
-            !std::filesystem::is_regular_file(fsFilePath, err))
+        if (!etag.empty())
+            resp->addHeader("ETag", etag);
+        // cache the response for 5 seconds by default
+        if (assetStore_ && etagIsFinal)
         {
-            defaultHandler_(req, std::move(callback));
-            return;
+            LOG_TRACE << "Save in cache for " << staticFilesCacheTime_
+                      << " seconds";
+            resp->setExpiredTime(staticFilesCacheTime_);
+            // The header is rendered once, the response is only read from
+            // then on and can be sent by all IO threads. Range requests
+            // are answered above and never get here, so an entry is always
+            // the whole file, in memory or sent with sendfile.
+            resp->freeze();
+            assetStore_->insert(servedPath,
+                                std::move(tag),
+                                resp,
+                                resp->getBody().size() + kAssetOverhead,
+                                staticFilesCacheTime_);
         }
     }
+    callback(resp);
+}
 
-    HttpResponsePtr resp;
-    auto &acceptEncoding = req->getHeaderBy("accept-encoding");
-
-    if (brStaticFlag_ && acceptEncoding.find("br") != std::string::npos)
-    {
-        // Find compressed file first.
-        auto brFileName = filePath + ".br";
-        std::filesystem::path fsBrFile(utils::toNativePath(brFileName));
-        std::error_code err;
-        if (std::filesystem::exists(fsBrFile, err) &&
-            std::filesystem::is_regular_file(fsBrFile, err))
-        {
-            auto ct = fileNameToContentTypeAndMime(filePath);
-            resp = HttpResponse::newFileResponse(
-                brFileName, "", ct.first, std::string(ct.second), req);
-            resp->addHeader("Content-Encoding", "br");
-        }
+std::string StaticFileRouter::makeETag(const std::string &servedPath,
+                                       const std::string &tag,
+                                       bool &isFinal)
+{
+    switch (etagMode_)
+    {
+    case ETagMode::kNone:
+        return {};
+    case ETagMode::kFileStat:
+        return "\"" + tag + "\"";
+    default:
+        break;
     }
-    if (!resp && gzipStaticFlag_ &&
-        acceptEncoding.find("gzip") != std::string::npos)
+    // Hashed by the worker of the hasher, the file_stat tag is used until
+    // the hash is ready
+    auto hash = hasher_ ? hasher_->find(servedPath, tag) : std::string{};
+    if (hash.empty())
     {
-        // Find compressed file first.
-        auto gzipFileName = filePath + ".gz";
-        std::filesystem::path fsGzipFile(utils::toNativePath(gzipFileName));
-        std::error_code err;
-        if (std::filesystem::exists(fsGzipFile, err) &&
-            std::filesystem::is_regular_file(fsGzipFile, err))
-        {
-            auto ct = fileNameToContentTypeAndMime(filePath);
-            resp = HttpResponse::newFileResponse(
-                gzipFileName, "", ct.first, std::string(ct.second), req);
-            resp->addHeader("Content-Encoding", "gzip");
-        }
+        isFinal = false;
+        return "\"" + tag + "\"";
+    }
+    return "\"" + hash + "\"";
+}
+
+HttpResponsePtr StaticFileRouter::newAssetResponse(
+    const std::string &filePath,
+    const std::string &servedPath,
+    const StaticFileInfo &info,
+    std::string_view encoding,
+    const std::string_view &defaultContentType,
+    const HttpRequestImplPtr &req) const
+{
+    auto ct = fileNameToContentTypeAndMime(filePath);
+    HttpResponsePtr resp;
+    std::string content;
+    if (readSmallFile(servedPath, maxAssetSize_, content))
+    {
+        resp = HttpResponse::newHttpResponse();
+        resp->setBody(std::move(content));
+        resp->setContentTypeCodeAndCustomString(ct.first, ct.second);
     }
-    if (!resp)
+    else
     {
-        auto ct = fileNameToContentTypeAndMime(filePath);
         resp = HttpResponse::newFileResponse(
-            filePath, "", ct.first, std::string(ct.second), req);
+            servedPath, "", ct.first, std::string(ct.second), req);
+        if (resp->statusCode() == k404NotFound)
+            return resp;
     }
-    if (resp->statusCode() != k404NotFound)
+    if (!encoding.empty())
     {
-        if (resp->getContentType() == CT_APPLICATION_OCTET_STREAM &&
-            !defaultContentType.empty())
-        {
-            resp->setContentTypeCodeAndCustomString(CT_CUSTOM,
-                                                    defaultContentType);
-        }
-        if (!fileStat.modifiedTimeStr_.empty())
-        {
-            resp->addHeader("Last-Modified", fileStat.modifiedTimeStr_);
-            resp->addHeader("Expires", "Thu, 01 Jan 1970 00:00:00 GMT");
-        }
-        if (enableRange_)
+        resp->addHeader("Content-Encoding", std::string(encoding));
+    }
+    // The identity body of a file with compressed siblings depends on
+    // Accept-Encoding as well
+    if (!encoding.empty() || hasEncodedVariants(filePath, info))
+    {
+        HttpResponseCompression::addVaryAcceptEncoding(
+            static_cast<HttpResponseImpl *>(resp.get()));
+    }
+    if (resp->getContentType() == CT_APPLICATION_OCTET_STREAM &&
+        !defaultContentType.empty())
+    {
+        resp->setContentTypeCodeAndCustomString(CT_CUSTOM,
+                                                defaultContentType);
+    }
+    if (!info.modifiedTimeStr_.empty())
+    {
+        resp->addHeader("Last-Modified", info.modifiedTimeStr_);
+        resp->addHeader("Expires", "Thu, 01 Jan 1970 00:00:00 GMT");
+    }
+    if (enableRange_)
+    {
+        resp->addHeader("accept-range", "bytes");
+    }
+    if (!headers_.empty())
+    {
+        for (auto &header : headers_)
         {
-            resp->addHeader("accept-range", "bytes");
+            resp->addHeader(header.first, header.second);
         }
-        if (!headers_.empty())
+    }
+    return resp;
+}
+
+std::string StaticFileRouter::precompressedFile(
+    const std::string &filePath,
+    const StaticFileInfo &info,
+    std::string_view acceptEncoding,
+    std::string_view &encoding) const
+{
+    if (!precompressor_)
+        return {};
+    auto ct = fileNameToContentTypeAndMime(filePath);
+    if (!HttpCompressionPolicy::isCompressible(app().compressionPolicy(),
+                                               ct.first,
+                                               ct.second,
+                                               info.fileSize_))
+    {
+        return {};
+    }
+    if (brStaticFlag_ &&
+        HttpResponseCompression::qValue(acceptEncoding,
+                                        ContentCoding::kBrotli) > 0)
+    {
+        auto path = precompressor_->find(filePath,
+                                         info.fileSize_,
+                                         info.modifiedTime_,
+                                         ContentCoding::kBrotli);
+        if (!path.empty())
         {
-            for (auto &header : headers_)
-            {
-                resp->addHeader(header.first, header.second);
-            }
+            encoding = "br";
+            return path;
         }
-        // cache the response for 5 seconds by default
-        if (staticFilesCacheTime_ >= 0)
+    }
+    if (gzipStaticFlag_ &&
+        HttpResponseCompression::qValue(acceptEncoding,
+                                        ContentCoding::kGzip) > 0)
+    {
+        auto path = precompressor_->find(filePath,
+                                         info.fileSize_,
+                                         info.modifiedTime_,
+                                         ContentCoding::kGzip);
+        if (!path.empty())
         {
-            LOG_TRACE << "Save in cache for " << staticFilesCacheTime_
-                      << " seconds";
-            resp->setExpiredTime(staticFilesCacheTime_);
-            staticFilesCache_->getThreadData()[filePath] = resp;
-            staticFilesCacheMap_->getThreadData()->insert(
-                filePath, 0, staticFilesCacheTime_, [this, filePath]()
-                {
-                    LOG_TRACE << "Erase cache";
-                    assert(staticFilesCache_->getThreadData().find(filePath) !=
-                           staticFilesCache_->getThreadData().end());
-                    staticFilesCache_->getThreadData().erase(filePath); });
+            encoding = "gzip";
+            return path;
         }
-        callback(resp);
-        return;
     }
-    callback(resp);
+    return {};
 }
 
 void StaticFileRouter::setFileTypes(const std::vector<std::string> &types)
@@ -578,3 +830,18 @@ void StaticFileRouter::defaultHandler(
     callback(HttpResponse::newNotFoundResponse(req));
 }
 }
+
+bool StaticFileRouter::hasEncodedVariants(const std::string &filePath,
+                                          const StaticFileInfo &info) const
+{
+    if ((brStaticFlag_ && info.hasBrFile_) ||
+        (gzipStaticFlag_ && info.hasGzipFile_))
+        return true;
+    if (!precompressor_ || (!brStaticFlag_ && !gzipStaticFlag_))
+        return false;
+    auto ct = fileNameToContentTypeAndMime(filePath);
+    return HttpCompressionPolicy::isCompressible(app().compressionPolicy(),
+                                                 ct.first,
+                                                 ct.second,
+                                                 info.fileSize_);
+}
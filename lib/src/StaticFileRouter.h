@@ -12,7 +12,11 @@
 
 #include "impl_forwards.h"
 #include "FiltersFunction.h"
-#include <xiaoHttp/CacheMap.h>
+#include "StaticAssetStore.h"
+#include "StaticFileHasher.h"
+#include "StaticFileInfoCache.h"
+#include "StaticFilePrecompressor.h"
+#include "StaticFileWatcher.h"
 #include <xiaoHttp/IOThreadStorage.h>
 
 #include <functional>
@@ -26,6 +30,13 @@ namespace xiaoHttp
     {
 
     public:
+        enum class ETagMode : uint8_t
+        {
+            kNone,
+            kFileStat,   // the inode, the size and the modification time
+            kContentHash // a hash of the content, computed once per version
+        };
+
         static StaticFileRouter &instance()
         {
             static StaticFileRouter inst;
@@ -56,6 +67,52 @@ namespace xiaoHttp
             brStaticFlag_ = useBrStatic;
         }
 
+        /**
+         * @brief Bound the per-thread cache of file metadata.
+         *
+         * @param maxEntries The number of paths cached per IO thread, 0
+         * disables the cache.
+         * @param ttl The seconds a cached stat() result is trusted.
+         */
+        void setFileInfoCache(size_t maxEntries, double ttl)
+        {
+            fileInfoCacheSize_ = maxEntries;
+            fileInfoCacheTtl_ = ttl;
+        }
+
+        /// Drop the cached responses and metadata of files as soon as they
+        /// change on disk, Linux only.
+        void setFileWatching(bool watch)
+        {
+            watchFiles_ = watch;
+        }
+
+        /**
+         * @brief Bound the responses kept in memory.
+         *
+         * @param maxBytes The memory shared by all IO threads, 0 disables
+         * the cache.
+         * @param maxAssetSize Larger files are sent from the disk, only
+         * their headers are kept.
+         */
+        void setAssetStore(size_t maxBytes, size_t maxAssetSize)
+        {
+            assetStoreSize_ = maxBytes;
+            maxAssetSize_ = maxAssetSize;
+        }
+
+        void setETagMode(ETagMode mode)
+        {
+            etagMode_ = mode;
+        }
+
+        /// Compress static files in the background into this directory, an
+        /// empty one disables it.
+        void setPrecompressionDir(const std::string &dir)
+        {
+            precompressionDir_ = dir;
+        }
+
         void init(const std::vector<xiaoNet::EventLoop *> &ioLoops);
         void reset();
 
@@ -118,6 +175,49 @@ namespace xiaoHttp
             const HttpRequestPtr &req,
             std::function<void(const HttpResponsePtr &)> &&callback);
 
+        // Forget the metadata cached about a path on the current IO thread,
+        // an empty path drops everything.
+        void invalidate(const std::string &path);
+
+        // Build the response of a file, @p servedPath is the file itself or
+        // its precompressed sibling.
+        HttpResponsePtr newAssetResponse(
+            const std::string &filePath,
+            const std::string &servedPath,
+            const StaticFileInfo &info,
+            std::string_view encoding,
+            const std::string_view &defaultContentType,
+            const HttpRequestImplPtr &req) const;
+
+        // The ETag of the served file, empty if ETags are disabled. The tag
+        // identifies the version of the file. @p isFinal is set to false
+        // when the file_stat tag stands in for a hash not computed yet.
+        std::string makeETag(const std::string &servedPath,
+                             const std::string &tag,
+                             bool &isFinal);
+
+        // Return the precompressed version of a file from the cache
+        // directory and set @p encoding, or queue the job and return an
+        // empty string.
+        std::string precompressedFile(const std::string &filePath,
+                                      const StaticFileInfo &info,
+                                      std::string_view acceptEncoding,
+                                      std::string_view &encoding) const;
+
+        // Whether a compressed variant of the file could be served, the
+        // responses of the file then vary on Accept-Encoding
+        bool hasEncodedVariants(const std::string &filePath,
+                                const StaticFileInfo &info) const;
+
+        StaticFileInfoPtr fileInfo(const std::string &path) const
+        {
+            if (fileInfoCache_)
+                return fileInfoCache_->getThreadData().get(path);
+            return StaticFileInfoCache::load(path,
+                                             brStaticFlag_,
+                                             gzipStaticFlag_);
+        }
+
         std::set<std::string> fileTypeSet_{"html",
                                            "js",
                                            "css",
@@ -142,12 +242,20 @@ namespace xiaoHttp
         bool enableRange_{true};
         bool gzipStaticFlag_{true};
         bool brStaticFlag_{true};
-        std::unique_ptr<
-            IOThreadStorage<std::unique_ptr<CacheMap<std::string, char>>>>
-            staticFilesCacheMap_;
-        std::unique_ptr<
-            IOThreadStorage<std::unordered_map<std::string, HttpRequestPtr>>>
-            staticFilesCache_;
+        size_t assetStoreSize_{64 * 1024 * 1024};
+        size_t maxAssetSize_{256 * 1024};
+        // The full 200 responses of the served files, keyed by path. The
+        // files larger than maxAssetSize_ are kept as sendfile responses.
+        std::unique_ptr<StaticAssetStore> assetStore_;
+        size_t fileInfoCacheSize_{1024};
+        double fileInfoCacheTtl_{5.0};
+        std::unique_ptr<IOThreadStorage<StaticFileInfoCache>> fileInfoCache_;
+        ETagMode etagMode_{ETagMode::kFileStat};
+        std::unique_ptr<StaticFileHasher> hasher_;
+        std::string precompressionDir_;
+        std::unique_ptr<StaticFilePrecompressor> precompressor_;
+        bool watchFiles_{false};
+        std::unique_ptr<StaticFileWatcher> watcher_;
         std::vector<std::pair<std::string, std::string>> headers_;
         bool implicitPageEnable_{true};
         std::string implicitPage_{"index.html"};
@@ -186,6 +294,8 @@ namespace xiaoHttp
             }
         };
 
+        static std::string realLocationOf(const Location &location);
+
         std::shared_ptr<IOThreadStorage<std::vector<Location>>> ioLocationsPtr_;
         std::vector<Location> locations_;
     };
@@ -0,0 +1,182 @@
+/**
+ * @file StaticFileWatcher.cpp
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-15
+ *
+ *
+ */
+
+#include "StaticFileWatcher.h"
+#include <xiaoLog/Logger.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <filesystem>
+#endif
+
+using namespace xiaoHttp;
+
+#ifdef __linux__
+
+static constexpr uint32_t kWatchMask =
+    IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+    IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+StaticFileWatcher::StaticFileWatcher(Callback callback)
+    : callback_(std::move(callback)),
+      inotifyFd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)),
+      wakeupFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+{
+    if (inotifyFd_ < 0 || wakeupFd_ < 0)
+        LOG_ERROR << "Failed to create the static file watcher";
+}
+
+StaticFileWatcher::~StaticFileWatcher()
+{
+    if (thread_.joinable())
+    {
+        uint64_t one = 1;
+        if (write(wakeupFd_, &one, sizeof(one)) < 0)
+            LOG_ERROR << "Failed to stop the static file watcher";
+        thread_.join();
+    }
+    if (inotifyFd_ >= 0)
+        close(inotifyFd_);
+    if (wakeupFd_ >= 0)
+        close(wakeupFd_);
+}
+
+bool StaticFileWatcher::addRoot(const std::string &dir)
+{
+    if (inotifyFd_ < 0)
+        return false;
+    std::error_code err;
+    if (!std::filesystem::is_directory(dir, err))
+        return false;
+    addWatches(dir);
+    return true;
+}
+
+void StaticFileWatcher::addWatches(const std::string &dir)
+{
+    auto wd = inotify_add_watch(inotifyFd_, dir.c_str(), kWatchMask);
+    if (wd < 0)
+    {
+        LOG_ERROR << "Failed to watch " << dir;
+        return;
+    }
+    auto &watched = watchDirs_[wd];
+    watched = dir;
+    while (watched.size() > 1 && watched.back() == '/')
+        watched.pop_back();
+    std::error_code err;
+    for (std::filesystem::directory_iterator iter(dir, err), end;
+         !err && iter != end;
+         iter.increment(err))
+    {
+        if (iter->is_directory(err) && !iter->is_symlink(err))
+            addWatches(iter->path().string());
+    }
+}
+
+bool StaticFileWatcher::start()
+{
+    if (inotifyFd_ < 0 || wakeupFd_ < 0 || thread_.joinable())
+        return false;
+    thread_ = std::thread([this] { run(); });
+    return true;
+}
+
+void StaticFileWatcher::run()
+{
+    alignas(struct inotify_event) char
+        buffer[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)];
+    struct pollfd fds[2] = {{inotifyFd_, POLLIN, 0}, {wakeupFd_, POLLIN, 0}};
+    while (true)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            LOG_ERROR << "The static file watcher stopped, poll failed";
+            return;
+        }
+        if (fds[1].revents != 0)
+            return;
+        auto len = read(inotifyFd_, buffer, sizeof(buffer));
+        if (len <= 0)
+            continue;
+        for (char *ptr = buffer; ptr < buffer + len;)
+        {
+            auto event = reinterpret_cast<struct inotify_event *>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                callback_(std::string());
+                continue;
+            }
+            auto iter = watchDirs_.find(event->wd);
+            if (iter == watchDirs_.end())
+                continue;
+            if (event->mask & IN_IGNORED)
+            {
+                watchDirs_.erase(iter);
+                continue;
+            }
+            if (event->len == 0)
+            {
+                // The watched directory itself was moved or deleted
+                callback_(std::string());
+                continue;
+            }
+            auto path = iter->second + "/" + event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                    addWatches(path);
+                // Files below a moved directory are not reported one by
+                // one
+                callback_(std::string());
+                continue;
+            }
+            callback_(path);
+        }
+    }
+}
+
+#else
+
+StaticFileWatcher::StaticFileWatcher(Callback callback)
+    : callback_(std::move(callback))
+{
+}
+
+StaticFileWatcher::~StaticFileWatcher() = default;
+
+bool StaticFileWatcher::addRoot(const std::string &)
+{
+    return false;
+}
+
+void StaticFileWatcher::addWatches(const std::string &)
+{
+}
+
+bool StaticFileWatcher::start()
+{
+    LOG_ERROR << "Watching static files is only supported on Linux";
+    return false;
+}
+
+void StaticFileWatcher::run()
+{
+}
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * @file StaticFileWatcher.h
+ * @author Guo Xiao (746921314@qq.com)
+ * @brief
+ * @version 0.1
+ * @date 2025-02-15
+ *
+ *
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace xiaoHttp
+{
+    /**
+     * @brief Report the changes under some directory trees with inotify.
+     *
+     * The callback is called on the thread of the watcher with the path of
+     * the file that changed. An empty path means that anything may have
+     * changed, a directory was moved or events were lost.
+     *
+     * Only Linux is supported, on other systems start() returns false and
+     * nothing is reported.
+     */
+    class StaticFileWatcher
+    {
+    public:
+        using Callback = std::function<void(const std::string &path)>;
+
+        explicit StaticFileWatcher(Callback callback);
+        ~StaticFileWatcher();
+
+        StaticFileWatcher(const StaticFileWatcher &) = delete;
+        StaticFileWatcher &operator=(const StaticFileWatcher &) = delete;
+
+        /// Watch a directory and its subdirectories, call it before start().
+        bool addRoot(const std::string &dir);
+
+        bool start();
+
+    private:
+        void addWatches(const std::string &dir);
+        void run();
+
+        Callback callback_;
+        int inotifyFd_{-1};
+        int wakeupFd_{-1};
+        // watch descriptor -> directory, only used by the watcher thread
+        // once it is started
+        std::unordered_map<int, std::string> watchDirs_;
+        std::thread thread_;
+    };
+}
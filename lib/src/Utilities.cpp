@@ -10,6 +10,8 @@
 
 #include <xiaoHttp/utils/Utilities.h>
 #include <xiaoLog/Date.h>
+#include "Digests.h"
+#include "HttpHeaderScanner.h"
 
 #include <mutex>
 
@@ -767,67 +769,57 @@ namespace xiaoHttp
 
         bool needUrlDecoding(const char *begin, const char *end)
         {
-            return std::find_if(begin, end, [](const char c)
-                                { return c == '+' || c == '%'; }) != end;
+            // The scan is vectorized, most paths and keys have nothing to
+            // decode.
+            return HttpHeaderScanner::findFirstOf(begin, end, '%', '+', '+') !=
+                   nullptr;
+        }
+
+        static int hexDigitValue(char c)
+        {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
         }
 
         std::string urlDecode(const char *begin, const char *end)
         {
             std::string result;
-            size_t len = end - begin;
-            result.reserve(len * 2);
-            int hex = 0;
-            for (size_t i = 0; i < len; ++i)
+            // Decoding never makes the string longer
+            result.reserve(end - begin);
+            while (begin < end)
             {
-                switch (begin[i])
+                // The runs between two escapes are copied as a whole
+                auto special =
+                    HttpHeaderScanner::findFirstOf(begin, end, '%', '+', '+');
+                if (!special)
                 {
-                case '+':
-                    result += ' ';
-                    break;
-                case '%':
-                    if ((i + 2) < len && isxdigit(begin[i + 1]) &&
-                        isxdigit(begin[i + 2]))
-                    {
-                        unsigned int x1 = begin[i + 1];
-                        if (x1 >= '0' && x1 <= '9')
-                        {
-                            x1 -= '0';
-                        }
-                        else if (x1 >= 'a' && x1 <= 'f')
-                        {
-                            x1 = x1 - 'a' + 10;
-                        }
-                        else if (x1 >= 'A' && x1 <= 'F')
-                        {
-                            x1 = x1 - 'A' + 10;
-                        }
-                        unsigned int x2 = begin[i + 2];
-                        if (x2 >= '0' && x2 <= '9')
-                        {
-                            x2 -= '0';
-                        }
-                        else if (x2 >= 'a' && x2 <= 'f')
-                        {
-                            x2 = x2 - 'a' + 10;
-                        }
-                        else if (x2 >= 'A' && x2 <= 'F')
-                        {
-                            x2 = x2 - 'A' + 10;
-                        }
-                        hex = x1 * 16 + x2;
-
-                        result += char(hex);
-                        i += 2;
-                    }
-                    else
-                    {
-                        result += '%';
-                    }
-                    break;
-                default:
-                    result += begin[i];
+                    result.append(begin, end);
                     break;
                 }
+                result.append(begin, special);
+                begin = special + 1;
+                if (*special == '+')
+                {
+                    result += ' ';
+                    continue;
+                }
+                int high, low;
+                if (end - special > 2 &&
+                    (high = hexDigitValue(special[1])) >= 0 &&
+                    (low = hexDigitValue(special[2])) >= 0)
+                {
+                    result += static_cast<char>(high * 16 + low);
+                    begin = special + 3;
+                }
+                else
+                {
+                    result += '%';
+                }
             }
             return result;
         }
@@ -1104,6 +1096,20 @@ namespace xiaoHttp
             return ret;
         }
 
+        std::string getMd5(const char *data, const size_t dataLen)
+        {
+            Md5Digest digest;
+            digest.update(data, dataLen);
+            return digest.hexDigest();
+        }
+
+        std::string getSha256(const char *data, const size_t dataLen)
+        {
+            Sha256Digest digest;
+            digest.update(data, dataLen);
+            return digest.hexDigest();
+        }
+
         namespace internal
         {
             const size_t fixedRandomNumber = []()
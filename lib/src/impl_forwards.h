@@ -42,6 +42,11 @@ namespace xiaoHttp
     class SessionManager;
     class HttpServer;
 
+    namespace internal
+    {
+        class ResponseStreamFlow;
+    }
+
     namespace orm
     {
         class DbClient;
@@ -0,0 +1,147 @@
+#include "../../src/HttpCompressionPolicy.h"
+#include "../../src/HttpCompressor.h"
+#include <xiaoHttp/xiaoHttp_test.h>
+#include <zlib.h>
+#include <chrono>
+#include <string>
+
+using namespace xiaoHttp;
+
+static std::string gunzip(const std::string &data)
+{
+    z_stream strm{};
+    std::string out;
+    if (inflateInit2(&strm, MAX_WBITS + 16) != Z_OK)
+        return out;
+    strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    strm.avail_in = static_cast<uInt>(data.size());
+    char buf[4096];
+    int ret;
+    do
+    {
+        strm.next_out = reinterpret_cast<Bytef *>(buf);
+        strm.avail_out = sizeof(buf);
+        ret = inflate(&strm, Z_NO_FLUSH);
+        out.append(buf, sizeof(buf) - strm.avail_out);
+    } while (ret == Z_OK);
+    inflateEnd(&strm);
+    return ret == Z_STREAM_END ? out : std::string();
+}
+
+XIAOHTTP_TEST(HttpCompressorGzipWholeBody)
+{
+    std::string body;
+    for (int i = 0; i < 10000; ++i)
+        body += "line " + std::to_string(i) + " of the response body\n";
+    auto compressed = HttpCompressor::compress(ContentCoding::kGzip,
+                                               6,
+                                               body.data(),
+                                               body.size());
+    REQUIRE(!compressed.empty());
+    CHECK(compressed.size() < body.size() / 4);
+    CHECK(gunzip(compressed) == body);
+    // The pooled compressor is reset before it is used again
+    CHECK(HttpCompressor::compress(ContentCoding::kGzip,
+                                   6,
+                                   body.data(),
+                                   body.size()) == compressed);
+    // A different level gives a different result, a pooled compressor is
+    // switched to it
+    auto fast = HttpCompressor::compress(ContentCoding::kGzip,
+                                         1,
+                                         body.data(),
+                                         body.size());
+    CHECK(fast != compressed);
+    CHECK(gunzip(fast) == body);
+}
+
+XIAOHTTP_TEST(HttpCompressorGzipStream)
+{
+    auto compressor = HttpCompressor::acquire(ContentCoding::kGzip, 6);
+    REQUIRE(compressor != nullptr);
+    std::string out;
+    REQUIRE(compressor->compress("hello ",
+                                 6,
+                                 StreamCompressor::Flush::kSync,
+                                 out));
+    // A sync flush makes the data seen so far decodable
+    CHECK(out.size() > 0);
+    REQUIRE(compressor->compress("world",
+                                 5,
+                                 StreamCompressor::Flush::kNone,
+                                 out));
+    REQUIRE(compressor->compress(nullptr,
+                                 0,
+                                 StreamCompressor::Flush::kFinish,
+                                 out));
+    CHECK(gunzip(out) == "hello world");
+    CHECK(HttpCompressor::name(compressor->coding()) == "gzip");
+}
+
+XIAOHTTP_TEST(HttpCompressionPolicyTypes)
+{
+    CompressionPolicy policy;
+    CHECK(HttpCompressionPolicy::isCompressible(policy,
+                                                CT_TEXT_HTML,
+                                                "text/html; charset=utf-8",
+                                                4096));
+    CHECK(!HttpCompressionPolicy::isCompressible(policy,
+                                                 CT_TEXT_HTML,
+                                                 "text/html; charset=utf-8",
+                                                 100));
+    CHECK(!HttpCompressionPolicy::isCompressible(policy,
+                                                 CT_APPLICATION_OCTET_STREAM,
+                                                 "application/octet-stream",
+                                                 4096));
+
+    policy.mimeTypes = {"text/", "application/json"};
+    CHECK(HttpCompressionPolicy::isCompressible(
+        policy,
+        CT_CUSTOM,
+        "Application/JSON; charset=utf-8",
+        HttpCompressionPolicy::unknownLength));
+    CHECK(HttpCompressionPolicy::isCompressible(policy,
+                                                CT_TEXT_CSS,
+                                                "text/css",
+                                                4096));
+    CHECK(!HttpCompressionPolicy::isCompressible(policy,
+                                                 CT_APPLICATION_XML,
+                                                 "application/xml",
+                                                 4096));
+}
+
+XIAOHTTP_TEST(HttpCompressionPolicyLoad)
+{
+    using namespace std::chrono_literals;
+    CompressionPolicy policy;
+    policy.reduceLevelBusyRatio = 0.5;
+    policy.skipBusyRatio = 0.9;
+    CHECK(HttpCompressionPolicy::level(policy, ContentCoding::kGzip) ==
+          policy.gzipLevel);
+
+    // The windows are closed by passing the time, they are put ahead of
+    // the real clock so level() does not close them.
+    auto start = std::chrono::steady_clock::now() + 1h;
+    HttpCompressionPolicy::busyRatio(start);
+    HttpCompressionPolicy::addBusyTime(600ms, start + 200ms);
+    // The window is still open
+    CHECK(HttpCompressionPolicy::busyRatio(start + 900ms) < 0.01);
+    auto ratio = HttpCompressionPolicy::busyRatio(start + 1s);
+    CHECK(ratio > 0.59);
+    CHECK(ratio < 0.61);
+    CHECK(HttpCompressionPolicy::level(policy, ContentCoding::kGzip) ==
+          HttpCompressor::fastestLevel(ContentCoding::kGzip));
+
+    // A thread busy for the whole last second
+    HttpCompressionPolicy::addBusyTime(2s, start + 1500ms);
+    CHECK(HttpCompressionPolicy::busyRatio(start + 2s) == 1.0);
+    CHECK(HttpCompressionPolicy::level(policy, ContentCoding::kGzip) == -1);
+    policy.skipBusyRatio = 0.0;
+    CHECK(HttpCompressionPolicy::level(policy, ContentCoding::kGzip) ==
+          HttpCompressor::fastestLevel(ContentCoding::kGzip));
+
+    // An idle thread gets a ratio over the whole idle period
+    CHECK(HttpCompressionPolicy::busyRatio(start + 12s) == 0.0);
+    CHECK(HttpCompressionPolicy::level(policy, ContentCoding::kGzip) ==
+          policy.gzipLevel);
+}
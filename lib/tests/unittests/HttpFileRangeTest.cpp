@@ -0,0 +1,138 @@
+#include "../../src/HttpFileRange.h"
+#include <xiaoHttp/xiaoHttp_test.h>
+#include <string>
+
+using namespace xiaoHttp;
+
+XIAOHTTP_TEST(HttpFileRangeSingle)
+{
+    std::vector<FileRange> ranges;
+    CHECK(parseRangeHeader("bytes=0-9", 100, ranges) ==
+          FileRangeParseResult::SinglePart);
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].start == 0);
+    CHECK(ranges[0].end == 10);
+
+    // Open ended and past the end are cut at the length
+    CHECK(parseRangeHeader("bytes=90-", 100, ranges) ==
+          FileRangeParseResult::SinglePart);
+    CHECK(ranges[0].start == 90);
+    CHECK(ranges[0].end == 100);
+    CHECK(parseRangeHeader("bytes=50-1000", 100, ranges) ==
+          FileRangeParseResult::SinglePart);
+    CHECK(ranges[0].start == 50);
+    CHECK(ranges[0].end == 100);
+}
+
+XIAOHTTP_TEST(HttpFileRangeSuffix)
+{
+    std::vector<FileRange> ranges;
+    CHECK(parseRangeHeader("bytes=-10", 100, ranges) ==
+          FileRangeParseResult::SinglePart);
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].start == 90);
+    CHECK(ranges[0].end == 100);
+
+    // A suffix longer than the file is the whole file
+    CHECK(parseRangeHeader("bytes=-500", 100, ranges) ==
+          FileRangeParseResult::SinglePart);
+    CHECK(ranges[0].start == 0);
+    CHECK(ranges[0].end == 100);
+
+    CHECK(parseRangeHeader("bytes=-0", 100, ranges) ==
+          FileRangeParseResult::NotSatisfiable);
+}
+
+XIAOHTTP_TEST(HttpFileRangeOverflow)
+{
+    std::vector<FileRange> ranges;
+    CHECK(parseRangeHeader("bytes=5-18446744073709551615", 100, ranges) ==
+          FileRangeParseResult::SinglePart);
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].start == 5);
+    CHECK(ranges[0].end == 100);
+
+    // Too large for size_t
+    CHECK(parseRangeHeader("bytes=5-18446744073709551616", 100, ranges) ==
+          FileRangeParseResult::InvalidRange);
+    CHECK(parseRangeHeader("bytes=-18446744073709551616", 100, ranges) ==
+          FileRangeParseResult::InvalidRange);
+}
+
+XIAOHTTP_TEST(HttpFileRangeMerge)
+{
+    std::vector<FileRange> ranges;
+    CHECK(parseRangeHeader("bytes=50-59, 0-9,5-19 ,60-69", 100, ranges) ==
+          FileRangeParseResult::MultiPart);
+    REQUIRE(ranges.size() == 2);
+    CHECK(ranges[0].start == 0);
+    CHECK(ranges[0].end == 20);
+    // Adjacent ranges are merged too
+    CHECK(ranges[1].start == 50);
+    CHECK(ranges[1].end == 70);
+
+    CHECK(parseRangeHeader("bytes=0-10,-95", 100, ranges) ==
+          FileRangeParseResult::SinglePart);
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].start == 0);
+    CHECK(ranges[0].end == 100);
+}
+
+XIAOHTTP_TEST(HttpFileRangeLimit)
+{
+    std::vector<FileRange> ranges;
+    std::string header = "bytes=";
+    for (size_t i = 0; i < kMaxFileRanges; ++i)
+        header += std::to_string(i * 2) + "-" + std::to_string(i * 2) + ",";
+    header.pop_back();
+    CHECK(parseRangeHeader(header, 1000, ranges) ==
+          FileRangeParseResult::MultiPart);
+    CHECK(ranges.size() == kMaxFileRanges);
+
+    header += "," + std::to_string(kMaxFileRanges * 2) + "-" +
+              std::to_string(kMaxFileRanges * 2);
+    CHECK(parseRangeHeader(header, 1000, ranges) ==
+          FileRangeParseResult::InvalidRange);
+    CHECK(ranges.empty());
+}
+
+XIAOHTTP_TEST(HttpFileRangeSpecLimit)
+{
+    std::vector<FileRange> ranges;
+    // Merged into a single range, but rejected while parsing
+    std::string header = "bytes=";
+    for (size_t i = 0; i < 2 * kMaxFileRanges; ++i)
+        header += "0-9,";
+    header.pop_back();
+    CHECK(parseRangeHeader(header, 100, ranges) ==
+          FileRangeParseResult::SinglePart);
+    CHECK(ranges.size() == 1);
+
+    header += ",0-9";
+    CHECK(parseRangeHeader(header, 100, ranges) ==
+          FileRangeParseResult::InvalidRange);
+    CHECK(ranges.empty());
+}
+
+XIAOHTTP_TEST(HttpFileRangeInvalid)
+{
+    std::vector<FileRange> ranges;
+    CHECK(parseRangeHeader("bytes=100-", 100, ranges) ==
+          FileRangeParseResult::NotSatisfiable);
+    CHECK(parseRangeHeader("bytes=200-300,150-", 100, ranges) ==
+          FileRangeParseResult::NotSatisfiable);
+    CHECK(parseRangeHeader("bytes=-5", 0, ranges) ==
+          FileRangeParseResult::NotSatisfiable);
+    CHECK(ranges.empty());
+
+    CHECK(parseRangeHeader("items=0-9", 100, ranges) ==
+          FileRangeParseResult::InvalidRange);
+    CHECK(parseRangeHeader("bytes=9-0", 100, ranges) ==
+          FileRangeParseResult::InvalidRange);
+    CHECK(parseRangeHeader("bytes=a-9", 100, ranges) ==
+          FileRangeParseResult::InvalidRange);
+    CHECK(parseRangeHeader("bytes=5", 100, ranges) ==
+          FileRangeParseResult::InvalidRange);
+    CHECK(parseRangeHeader("bytes=-", 100, ranges) ==
+          FileRangeParseResult::InvalidRange);
+}
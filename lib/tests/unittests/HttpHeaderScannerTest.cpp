@@ -0,0 +1,138 @@
+#include "../../src/HttpHeaderScanner.h"
+#include <xiaoHttp/xiaoHttp_test.h>
+#include <string>
+
+using namespace xiaoHttp;
+
+XIAOHTTP_TEST(HttpHeaderScannerFindFirstOf)
+{
+    std::string s(100, 'a');
+    s[77] = ':';
+    s[90] = '\n';
+    CHECK(HttpHeaderScanner::findFirstOf(s.data(),
+                                         s.data() + s.size(),
+                                         ':',
+                                         '\n',
+                                         '\n') == s.data() + 77);
+    CHECK(HttpHeaderScanner::findFirstOf(s.data(),
+                                         s.data() + 77,
+                                         ':',
+                                         '\n',
+                                         '\n') == nullptr);
+    CHECK(HttpHeaderScanner::findCRLF(s.data(), s.data() + s.size()) ==
+          nullptr);
+    s[89] = '\r';
+    CHECK(HttpHeaderScanner::findCRLF(s.data(), s.data() + s.size()) ==
+          s.data() + 89);
+}
+
+XIAOHTTP_TEST(HttpHeaderScannerRequestHead)
+{
+    std::string head =
+        "GET /api/v1/users?id=3 HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "Content-Length: 12\r\n"
+        "\r\n"
+        "hello world!";
+    HttpRequestHeadOffsets offsets;
+    auto result = HttpHeaderScanner::scanRequestHead(head.data(),
+                                                     head.data() + head.size(),
+                                                     offsets);
+    REQUIRE(result == HttpHeadScanResult::kComplete);
+    CHECK(head.substr(0, offsets.methodEnd) == "GET");
+    CHECK(head.substr(offsets.targetBegin,
+                      offsets.targetEnd - offsets.targetBegin) ==
+          "/api/v1/users?id=3");
+    CHECK(head.substr(offsets.queryBegin,
+                      offsets.targetEnd - offsets.queryBegin) == "id=3");
+    CHECK(head.substr(offsets.targetEnd + 1,
+                      offsets.requestLineEnd - offsets.targetEnd - 1) ==
+          "HTTP/1.1");
+    REQUIRE(offsets.headers.size() == 2);
+    CHECK(head.substr(offsets.headers[1].fieldBegin,
+                      offsets.headers[1].colon -
+                          offsets.headers[1].fieldBegin) == "Content-Length");
+    CHECK(head.substr(offsets.headEnd) == "hello world!");
+}
+
+XIAOHTTP_TEST(HttpHeaderScannerIncompleteAndMalformed)
+{
+    HttpRequestHeadOffsets offsets;
+    std::string partial = "POST /upload HTTP/1.1\r\nHost: local";
+    CHECK(HttpHeaderScanner::scanRequestHead(partial.data(),
+                                             partial.data() + partial.size(),
+                                             offsets) ==
+          HttpHeadScanResult::kIncomplete);
+    CHECK(offsets.methodEnd == 4);
+    CHECK(offsets.requestLineEnd != HttpRequestHeadOffsets::npos);
+
+    // Lines without a colon or a name are skipped
+    offsets.reset();
+    std::string noColon =
+        "GET / HTTP/1.1\r\nHost localhost\r\n: empty\r\nA: b\r\n\r\n";
+    CHECK(HttpHeaderScanner::scanRequestHead(noColon.data(),
+                                             noColon.data() + noColon.size(),
+                                             offsets) ==
+          HttpHeadScanResult::kComplete);
+    REQUIRE(offsets.headers.size() == 1);
+    CHECK(noColon.substr(offsets.headers[0].fieldBegin,
+                         offsets.headers[0].lineEnd -
+                             offsets.headers[0].fieldBegin) == "A: b");
+
+    std::string bareLf = "GET / HTTP/1.1\nHost: localhost\r\n\r\n";
+    CHECK(HttpHeaderScanner::scanRequestHead(bareLf.data(),
+                                             bareLf.data() + bareLf.size(),
+                                             offsets) ==
+          HttpHeadScanResult::kMalformed);
+}
+
+XIAOHTTP_TEST(HttpHeaderScannerResume)
+{
+    std::string head =
+        "PUT /files/a?b=c?d HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "no colon\r\n"
+        "Content-Type: text/plain\r\n"
+        "\r\n";
+    HttpRequestHeadOffsets whole;
+    REQUIRE(HttpHeaderScanner::scanRequestHead(head.data(),
+                                               head.data() + head.size(),
+                                               whole) ==
+            HttpHeadScanResult::kComplete);
+
+    // Fed one byte at a time, the result is the same
+    HttpRequestHeadOffsets offsets;
+    for (size_t len = 1; len < head.size(); ++len)
+    {
+        REQUIRE(HttpHeaderScanner::scanRequestHead(head.data(),
+                                                   head.data() + len,
+                                                   offsets) ==
+                HttpHeadScanResult::kIncomplete);
+        CHECK(offsets.scanPos <= len);
+    }
+    REQUIRE(HttpHeaderScanner::scanRequestHead(head.data(),
+                                               head.data() + head.size(),
+                                               offsets) ==
+            HttpHeadScanResult::kComplete);
+    CHECK(offsets.methodEnd == whole.methodEnd);
+    CHECK(offsets.queryBegin == whole.queryBegin);
+    CHECK(offsets.targetEnd == whole.targetEnd);
+    CHECK(offsets.requestLineEnd == whole.requestLineEnd);
+    CHECK(offsets.headEnd == head.size());
+    REQUIRE(offsets.headers.size() == 2);
+    for (size_t i = 0; i < offsets.headers.size(); ++i)
+    {
+        CHECK(offsets.headers[i].fieldBegin == whole.headers[i].fieldBegin);
+        CHECK(offsets.headers[i].colon == whole.headers[i].colon);
+        CHECK(offsets.headers[i].lineEnd == whole.headers[i].lineEnd);
+    }
+
+    // A complete head starts the next scan over
+    std::string next = "GET / HTTP/1.1\r\n\r\n";
+    CHECK(HttpHeaderScanner::scanRequestHead(next.data(),
+                                             next.data() + next.size(),
+                                             offsets) ==
+          HttpHeadScanResult::kComplete);
+    CHECK(offsets.headers.empty());
+    CHECK(offsets.headEnd == next.size());
+}
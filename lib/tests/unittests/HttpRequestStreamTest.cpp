@@ -0,0 +1,111 @@
+#include "../../src/HttpRequestImpl.h"
+#include <xiaoHttp/RequestStream.h>
+#include <xiaoHttp/xiaoHttp_test.h>
+#include <xiaoNet/net/EventLoop.h>
+#include <string>
+#include <vector>
+
+using namespace xiaoHttp;
+
+XIAOHTTP_TEST(HttpRequestStreamCredit)
+{
+    // Created in this thread, so the test runs in its loop thread
+    xiaoNet::EventLoop loop;
+    auto req = std::make_shared<HttpRequestImpl>(&loop);
+    req->streamStart();
+    req->appendToBody("abc", 3);
+
+    std::string received;
+    std::vector<std::string> events;
+    req->setStreamReader(RequestStreamReader::newReader(
+                             [&received](const char *data, size_t length) {
+                                 received.append(data, length);
+                             },
+                             [&events](std::exception_ptr ex) {
+                                 CHECK(!ex);
+                                 events.emplace_back("reader");
+                             }),
+                         2);
+    // The body received before the reader waits for credit too
+    CHECK(received == "ab");
+    req->waitForStreamFinish([&events]() { events.emplace_back("server"); });
+
+    req->appendToBody("defgh", 5);
+    CHECK(received == "ab");
+    req->grantStreamCredit(4);
+    CHECK(received == "abcdef");
+
+    // The finish waits behind the bytes without credit
+    req->streamFinish();
+    CHECK(events.empty());
+    req->grantStreamCredit(1);
+    CHECK(received == "abcdefg");
+    CHECK(events.empty());
+    req->grantStreamCredit(100);
+    CHECK(received == "abcdefgh");
+    REQUIRE(events.size() == 2);
+    CHECK(events[0] == "reader");
+    CHECK(events[1] == "server");
+    req->quitStreamMode();
+}
+
+XIAOHTTP_TEST(HttpRequestStreamWaitAfterFinish)
+{
+    xiaoNet::EventLoop loop;
+    auto req = std::make_shared<HttpRequestImpl>(&loop);
+    req->streamStart();
+
+    std::string received;
+    bool readerFinished{false};
+    req->setStreamReader(RequestStreamReader::newReader(
+                             [&received](const char *data, size_t length) {
+                                 received.append(data, length);
+                             },
+                             [&readerFinished](std::exception_ptr ex) {
+                                 CHECK(!ex);
+                                 readerFinished = true;
+                             }),
+                         0);
+    req->appendToBody("xyz", 3);
+    req->streamFinish();
+
+    // Finished on the wire, but not for the reader yet
+    bool serverFinished{false};
+    req->waitForStreamFinish([&serverFinished, &readerFinished]() {
+        CHECK(readerFinished);
+        serverFinished = true;
+    });
+    CHECK(!serverFinished);
+    req->grantStreamCredit(3);
+    CHECK(received == "xyz");
+    CHECK(serverFinished);
+    req->quitStreamMode();
+}
+
+XIAOHTTP_TEST(HttpRequestStreamQuitBeforeRead)
+{
+    xiaoNet::EventLoop loop;
+    auto req = std::make_shared<HttpRequestImpl>(&loop);
+    req->streamStart();
+
+    std::exception_ptr error;
+    req->setStreamReader(RequestStreamReader::newReader(
+                             [](const char *, size_t) {},
+                             [&error](std::exception_ptr ex) { error = ex; }),
+                         1);
+    req->appendToBody("12345", 5);
+    req->streamFinish();
+    CHECK(!error);
+
+    // The reader never granted the rest
+    req->quitStreamMode();
+    REQUIRE(error);
+    try
+    {
+        std::rethrow_exception(error);
+    }
+    catch (const StreamError &e)
+    {
+        CHECK(e.code() == StreamErrorCode::kConnectionBroken);
+    }
+}
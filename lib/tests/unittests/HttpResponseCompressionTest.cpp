@@ -0,0 +1,170 @@
+#include "../../src/HttpCompressionPolicy.h"
+#include "../../src/HttpResponseCompression.h"
+#include <xiaoHttp/xiaoHttp_test.h>
+#include <zlib.h>
+#include <chrono>
+#include <string>
+
+using namespace xiaoHttp;
+
+static std::string gunzip(std::string_view data)
+{
+    z_stream strm{};
+    std::string out;
+    if (inflateInit2(&strm, MAX_WBITS + 16) != Z_OK)
+        return out;
+    strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    strm.avail_in = static_cast<uInt>(data.size());
+    char buf[4096];
+    int ret;
+    do
+    {
+        strm.next_out = reinterpret_cast<Bytef *>(buf);
+        strm.avail_out = sizeof(buf);
+        ret = inflate(&strm, Z_NO_FLUSH);
+        out.append(buf, sizeof(buf) - strm.avail_out);
+    } while (ret == Z_OK);
+    inflateEnd(&strm);
+    return ret == Z_STREAM_END ? out : std::string();
+}
+
+static HttpResponsePtr newTextResponse(size_t length)
+{
+    std::string body;
+    while (body.size() < length)
+        body += "line " + std::to_string(body.size()) + " of the body\n";
+    body.resize(length);
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setContentTypeCode(CT_TEXT_PLAIN);
+    resp->setBody(std::move(body));
+    return resp;
+}
+
+XIAOHTTP_TEST(HttpResponseCompressionAcceptEncoding)
+{
+    auto gzip = ContentCoding::kGzip;
+    auto br = ContentCoding::kBrotli;
+    CHECK(HttpResponseCompression::qValue("gzip, deflate, br", br) == 1000);
+    CHECK(HttpResponseCompression::qValue("gzip;q=0.5, br;q=0", br) == 0);
+    CHECK(HttpResponseCompression::qValue("gzip;q=0.5, br;q=0", gzip) == 500);
+    CHECK(HttpResponseCompression::qValue("GZIP ; Q=0.25", gzip) == 250);
+    CHECK(HttpResponseCompression::qValue("x-gzip", gzip) == 1000);
+    // Whole tokens only
+    CHECK(HttpResponseCompression::qValue("xbr, gzipped", br) == 0);
+    CHECK(HttpResponseCompression::qValue("xbr, gzipped", gzip) == 0);
+    // "*" covers the codings that are not listed
+    CHECK(HttpResponseCompression::qValue("*;q=0.1, br;q=0", gzip) == 100);
+    CHECK(HttpResponseCompression::qValue("*;q=0.1, br;q=0", br) == 0);
+    CHECK(HttpResponseCompression::qValue("identity", gzip) == 0);
+    // A malformed q-value drops the element
+    CHECK(HttpResponseCompression::qValue("gzip;q=2", gzip) == 0);
+    CHECK(HttpResponseCompression::qValue("gzip;q=0.1234", gzip) == 0);
+
+    EnabledCodings enabled;
+    enabled.gzip = true;
+    ContentCoding coding;
+    CHECK(HttpResponseCompression::selectCoding("br, gzip", enabled, coding));
+    CHECK(coding == ContentCoding::kGzip);
+    CHECK(!HttpResponseCompression::selectCoding("gzip;q=0", enabled, coding));
+    CHECK(!HttpResponseCompression::selectCoding("", enabled, coding));
+    enabled.gzip = false;
+    CHECK(!HttpResponseCompression::selectCoding("gzip", enabled, coding));
+}
+
+XIAOHTTP_TEST(HttpResponseCompressionGzip)
+{
+    CompressionPolicy policy;
+    EnabledCodings enabled;
+    enabled.gzip = true;
+
+    auto resp = newTextResponse(4096);
+    auto body = std::string(resp->getBody());
+    auto compressed =
+        HttpResponseCompression::compress("gzip", resp, policy, enabled);
+    // Not shared, so compressed in place
+    CHECK(compressed == resp);
+    CHECK(compressed->getHeader("content-encoding") == "gzip");
+    CHECK(compressed->getHeader("vary") == "Accept-Encoding");
+    CHECK(gunzip(compressed->getBody()) == body);
+
+    // Not accepted by the client
+    auto refused = newTextResponse(4096);
+    HttpResponseCompression::compress("gzip;q=0", refused, policy, enabled);
+    CHECK(refused->getHeader("content-encoding").empty());
+
+    // An existing Vary is extended
+    auto varied = newTextResponse(4096);
+    varied->addHeader("Vary", "Origin");
+    HttpResponseCompression::compress("gzip", varied, policy, enabled);
+    CHECK(varied->getHeader("vary") == "Origin, Accept-Encoding");
+}
+
+XIAOHTTP_TEST(HttpResponseCompressionVariant)
+{
+    CompressionPolicy policy;
+    EnabledCodings enabled;
+    enabled.gzip = true;
+
+    auto resp = newTextResponse(4096);
+    auto body = std::string(resp->getBody());
+    resp->freeze();
+    auto first =
+        HttpResponseCompression::compress("gzip", resp, policy, enabled);
+    // A frozen response is shared, a compressed copy is made
+    REQUIRE(first != resp);
+    CHECK(resp->getBody() == body);
+    CHECK(resp->getHeader("content-encoding").empty());
+    CHECK(first->isFrozen());
+    CHECK(first->getHeader("content-encoding") == "gzip");
+    CHECK(first->getHeader("vary") == "Accept-Encoding");
+    CHECK(gunzip(first->getBody()) == body);
+
+    // The next request reuses the copy
+    auto second = HttpResponseCompression::compress("deflate, gzip",
+                                                    resp,
+                                                    policy,
+                                                    enabled);
+    CHECK(second == first);
+    // A client without gzip still gets the original
+    CHECK(HttpResponseCompression::compress("identity",
+                                            resp,
+                                            policy,
+                                            enabled) == resp);
+}
+
+XIAOHTTP_TEST(HttpResponseCompressionPolicy)
+{
+    // The defaults keep the checks shouldBeCompressed() used to make
+    CompressionPolicy policy;
+    EnabledCodings enabled;
+    enabled.gzip = true;
+    auto small = newTextResponse(policy.minSize - 1);
+    HttpResponseCompression::compress("gzip", small, policy, enabled);
+    CHECK(small->getHeader("content-encoding").empty());
+    auto binary = newTextResponse(4096);
+    binary->setContentTypeCode(CT_APPLICATION_OCTET_STREAM);
+    HttpResponseCompression::compress("gzip", binary, policy, enabled);
+    CHECK(binary->getHeader("content-encoding").empty());
+
+    policy.minSize = 100;
+    policy.mimeTypes = {"application/json"};
+    auto text = newTextResponse(500);
+    HttpResponseCompression::compress("gzip", text, policy, enabled);
+    CHECK(text->getHeader("content-encoding").empty());
+    auto json = newTextResponse(500);
+    json->setContentTypeCode(CT_APPLICATION_JSON);
+    HttpResponseCompression::compress("gzip", json, policy, enabled);
+    CHECK(json->getHeader("content-encoding") == "gzip");
+
+    // Too busy to compress, the window is put ahead of the real clock so
+    // it stays closed
+    policy.skipBusyRatio = 0.5;
+    auto start = std::chrono::steady_clock::now() + std::chrono::hours(10);
+    HttpCompressionPolicy::busyRatio(start);
+    HttpCompressionPolicy::addBusyTime(std::chrono::seconds(2), start);
+    CHECK(HttpCompressionPolicy::busyRatio(start + std::chrono::seconds(1)) ==
+          1.0);
+    auto busy = newTextResponse(4096);
+    HttpResponseCompression::compress("gzip", busy, policy, enabled);
+    CHECK(busy->getHeader("content-encoding").empty());
+}
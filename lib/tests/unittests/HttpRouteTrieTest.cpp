@@ -0,0 +1,61 @@
+#include "../../src/HttpRouteTrie.h"
+#include <xiaoHttp/xiaoHttp_test.h>
+#include <string>
+
+using namespace xiaoHttp;
+
+XIAOHTTP_TEST(HttpRouteTrieMatch)
+{
+    HttpRouteTrie trie;
+    CHECK(trie.insert("/api/v1/users/([^/]*)", 0));
+    CHECK(trie.insert("/api/v1/users/([^/]*)/posts/([^/]*)", 1));
+    CHECK(trie.insert("/static/(.*)", 2));
+    CHECK(trie.insert("/api/v1/info\\.json", 3));
+    auto acceptAll = [](size_t) { return true; };
+    HttpRouteTrie::Captures captures;
+
+    std::string path = "/api/v1/users/42/posts/7";
+    CHECK(trie.match(path, acceptAll, captures) == 1);
+    REQUIRE(captures.size() == 2);
+    CHECK(path.substr(captures[0].first, captures[0].second) == "42");
+    CHECK(path.substr(captures[1].first, captures[1].second) == "7");
+
+    path = "/static/css/site.css";
+    CHECK(trie.match(path, acceptAll, captures) == 2);
+    REQUIRE(captures.size() == 1);
+    CHECK(path.substr(captures[0].first, captures[0].second) ==
+          "css/site.css");
+
+    CHECK(trie.match("/api/v1/info.json", acceptAll, captures) == 3);
+    CHECK(trie.match("/api/v1/users", acceptAll, captures) ==
+          HttpRouteTrie::npos);
+    CHECK(trie.match("/static", acceptAll, captures) == HttpRouteTrie::npos);
+}
+
+XIAOHTTP_TEST(HttpRouteTriePriority)
+{
+    HttpRouteTrie trie;
+    CHECK(trie.insert("/files/([^/]*)", 0));
+    CHECK(trie.insert("/files/latest", 1));
+    CHECK(trie.insert("/(.*)", 2));
+    HttpRouteTrie::Captures captures;
+
+    // The route registered first wins, like the regex list did.
+    CHECK(trie.match("/files/latest", [](size_t) { return true; }, captures) ==
+          0);
+    CHECK(trie.match("/files/latest",
+                     [](size_t i) { return i != 0; },
+                     captures) == 1);
+    CHECK(trie.match("/other/path", [](size_t) { return true; }, captures) ==
+          2);
+}
+
+XIAOHTTP_TEST(HttpRouteTrieRejectsRegex)
+{
+    HttpRouteTrie trie;
+    CHECK(!trie.insert("/api/v[0-9]+/users", 0));
+    CHECK(!trie.insert("/api/.*", 1));
+    CHECK(!trie.insert("/file_([^/]*)\\.txt", 2));
+    CHECK(!trie.insert("^/api", 3));
+    CHECK(trie.empty());
+}
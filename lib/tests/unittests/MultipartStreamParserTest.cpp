@@ -0,0 +1,124 @@
+#include "../../src/MultipartStreamParser.h"
+#include "../../src/Digests.h"
+#include <xiaoHttp/xiaoHttp_test.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace xiaoHttp;
+
+namespace
+{
+    struct Part
+    {
+        MultipartHeader header;
+        std::string data;
+    };
+
+    // Feed the body in pieces of the given size
+    std::vector<Part> parseInPieces(MultipartStreamParser &parser,
+                                    const std::string &body,
+                                    size_t pieceSize)
+    {
+        std::vector<Part> parts;
+        for (size_t i = 0; i < body.size(); i += pieceSize)
+        {
+            parser.parse(
+                body.data() + i,
+                std::min(pieceSize, body.size() - i),
+                [&parts](MultipartHeader header) {
+                    parts.push_back({std::move(header), {}});
+                },
+                [&parts](const char *data, size_t length) {
+                    parts.back().data.append(data, length);
+                });
+        }
+        return parts;
+    }
+}
+
+XIAOHTTP_TEST(MultipartStreamParserPieces)
+{
+    std::string file(10000, 'x');
+    // Looks like the boundary but is not one
+    file.append("\r\n--abX\r\n--ab");
+    std::string body =
+        "preamble\r\n"
+        "--abc\r\n"
+        "Content-Disposition: form-data; name=\"field\"\r\n"
+        "\r\n"
+        "value\r\n"
+        "--abc\r\n"
+        "content-disposition: form-data; name=\"file\"; "
+        "filename=\"a.txt\"\r\n"
+        "Content-Type: text/plain\r\n"
+        "\r\n" +
+        file +
+        "\r\n--abc--\r\n";
+    for (size_t pieceSize : {size_t(1), size_t(5), size_t(64), body.size()})
+    {
+        MultipartStreamParser parser(
+            "multipart/form-data; boundary=\"abc\"");
+        auto parts = parseInPieces(parser, body, pieceSize);
+        CHECK(parser.isFinished());
+        REQUIRE(parts.size() == 2);
+        CHECK(parts[0].header.name == "field");
+        CHECK(parts[0].header.filename.empty());
+        CHECK(parts[0].data == "value");
+        CHECK(parts[1].header.filename == "a.txt");
+        CHECK(parts[1].header.contentType == "text/plain");
+        CHECK(parts[1].data == file);
+    }
+}
+
+XIAOHTTP_TEST(BoundarySearcherSplitReads)
+{
+    BoundarySearcher searcher("\r\n--boundary");
+    std::string text(1000, 'a');
+    CHECK(searcher.find(text) == std::string_view::npos);
+    CHECK(searcher.partialMatch(text) == text.size());
+    text.replace(500, 12, "\r\n--boundary");
+    CHECK(searcher.find(text) == 500);
+    CHECK(searcher.find(text, 501) == std::string_view::npos);
+    // A delimiter cut by the end of a read
+    for (size_t cut = 501; cut < 512; ++cut)
+    {
+        std::string_view head(text.data(), cut);
+        CHECK(searcher.find(head) == std::string_view::npos);
+        CHECK(searcher.partialMatch(head) == 500);
+    }
+    CHECK(searcher.partialMatch("abc\r\n-x") == 7);
+}
+
+XIAOHTTP_TEST(MultipartStreamParserErrors)
+{
+    MultipartStreamParser noBoundary("multipart/form-data");
+    CHECK(!noBoundary.isValid());
+
+    MultipartStreamParser parser("multipart/form-data; boundary=abc");
+    std::string body = "--abc\r\nContent-Type: text/plain\r\n\r\nvalue";
+    parseInPieces(parser, body, body.size());
+    CHECK(!parser.isValid());
+
+    MultipartStreamParser incomplete("multipart/form-data; boundary=abc");
+    body = "--abc\r\nContent-Disposition: form-data; name=\"a\"\r\n\r\nva";
+    parseInPieces(incomplete, body, 3);
+    CHECK(incomplete.isValid());
+    CHECK(!incomplete.isFinished());
+}
+
+XIAOHTTP_TEST(DigestsInPieces)
+{
+    std::string data(1000, 'a');
+    Md5Digest md5;
+    Sha256Digest sha256;
+    for (size_t i = 0; i < data.size(); i += 7)
+    {
+        md5.update(data.data() + i, std::min<size_t>(7, data.size() - i));
+        sha256.update(data.data() + i, std::min<size_t>(7, data.size() - i));
+    }
+    CHECK(md5.hexDigest() == "CABE45DCC9AE5B66BA86600CCA6B8BA8");
+    CHECK(sha256.hexDigest() ==
+          "41EDECE42D63E8D9BF515A9BA6932E1C"
+          "20CBC9F5A5D134645ADB5DB1B9737EA3");
+}
@@ -0,0 +1,74 @@
+#include "../../src/ResponseStreamFlow.h"
+#include <xiaoHttp/xiaoHttp_test.h>
+#include <vector>
+
+using namespace xiaoHttp::internal;
+
+XIAOHTTP_TEST(ResponseStreamFlowWatermark)
+{
+    // Without a connection the flow is driven by hand
+    auto flow = std::make_shared<ResponseStreamFlow>(nullptr);
+    int highCount = 0;
+    int drainCount = 0;
+    flow->setWatermarkCallbacks(
+        100,
+        [&highCount]() { ++highCount; },
+        [&drainCount]() { ++drainCount; });
+
+    std::vector<bool> results;
+    auto waiter = [&results](bool open) { results.push_back(open); };
+    // Not congested, the waiter is released right away
+    flow->waitForDrain(waiter);
+    REQUIRE(results.size() == 1);
+    CHECK(results[0]);
+
+    flow->onHighWatermark();
+    CHECK(flow->isCongested());
+    CHECK(highCount == 1);
+    // Reported once until the buffer drains
+    flow->onHighWatermark();
+    CHECK(highCount == 1);
+    flow->waitForDrain(waiter);
+    flow->waitForDrain(waiter);
+    CHECK(results.size() == 1);
+
+    flow->onWriteComplete();
+    CHECK(!flow->isCongested());
+    CHECK(drainCount == 1);
+    REQUIRE(results.size() == 3);
+    CHECK(results[1]);
+    CHECK(results[2]);
+    // A write complete without congestion is not a drain
+    flow->onWriteComplete();
+    CHECK(drainCount == 1);
+}
+
+XIAOHTTP_TEST(ResponseStreamFlowClose)
+{
+    auto flow = std::make_shared<ResponseStreamFlow>(nullptr);
+    int highCount = 0;
+    flow->setWatermarkCallbacks(
+        100, [&highCount]() { ++highCount; }, nullptr);
+    flow->onHighWatermark();
+    CHECK(highCount == 1);
+
+    std::vector<bool> results;
+    auto waiter = [&results](bool open) { results.push_back(open); };
+    flow->waitForDrain(waiter);
+    CHECK(results.empty());
+
+    // The waiters are released as failed
+    flow->close();
+    CHECK(!flow->isCongested());
+    REQUIRE(results.size() == 1);
+    CHECK(!results[0]);
+
+    // Nothing is reported after the close
+    flow->onHighWatermark();
+    CHECK(highCount == 1);
+    CHECK(!flow->isCongested());
+    flow->waitForDrain(waiter);
+    REQUIRE(results.size() == 2);
+    CHECK(!results[1]);
+    flow->close();
+}
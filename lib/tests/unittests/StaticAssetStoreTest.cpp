@@ -0,0 +1,80 @@
+#include "../../src/StaticAssetStore.h"
+#include <xiaoHttp/xiaoHttp_test.h>
+#include <string>
+#include <thread>
+
+using namespace xiaoHttp;
+
+XIAOHTTP_TEST(StaticAssetStoreBudget)
+{
+    StaticAssetStore store(100);
+    CHECK(store.insert("a", "", HttpResponse::newHttpResponse(), 40, 0));
+    CHECK(store.insert("b", "", HttpResponse::newHttpResponse(), 40, 0));
+    CHECK(store.find("a") != nullptr);
+    CHECK(store.insert("c", "", HttpResponse::newHttpResponse(), 40, 0));
+    CHECK(store.bytes() == 80);
+    int kept = (store.find("a") ? 1 : 0) + (store.find("b") ? 1 : 0) +
+               (store.find("c") ? 1 : 0);
+    CHECK(kept == 2);
+    CHECK(store.find("c") != nullptr);
+
+    // Larger than the whole budget
+    CHECK(!store.insert("d", "", HttpResponse::newHttpResponse(), 101, 0));
+    CHECK(store.find("d") == nullptr);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        store.insert("k" + std::to_string(i % 37),
+                     "",
+                     HttpResponse::newHttpResponse(),
+                     7 + i % 13,
+                     0);
+        CHECK(store.bytes() <= store.budget());
+    }
+    store.clear();
+    CHECK(store.bytes() == 0);
+}
+
+XIAOHTTP_TEST(StaticAssetStoreSecondChance)
+{
+    // Only absent keys are looked up until the end, a hit marks the entry
+    StaticAssetStore store(30);
+    CHECK(store.insert("a", "", HttpResponse::newHttpResponse(), 10, 0));
+    CHECK(store.insert("b", "", HttpResponse::newHttpResponse(), 10, 0));
+    CHECK(store.insert("c", "", HttpResponse::newHttpResponse(), 10, 0));
+
+    // All are new, the hand clears them in one turn and takes the first
+    CHECK(store.insert("d", "", HttpResponse::newHttpResponse(), 10, 0));
+    CHECK(store.find("a") == nullptr);
+
+    // b is used, so the hand passes it and takes c
+    CHECK(store.find("b") != nullptr);
+    CHECK(store.insert("e", "", HttpResponse::newHttpResponse(), 10, 0));
+    CHECK(store.find("c") == nullptr);
+
+    // d was new in the slot of a, b has not been used since it was passed
+    CHECK(store.insert("f", "", HttpResponse::newHttpResponse(), 10, 0));
+    CHECK(store.find("b") == nullptr);
+    CHECK(store.find("d") != nullptr);
+    CHECK(store.find("e") != nullptr);
+    CHECK(store.find("f") != nullptr);
+    CHECK(store.bytes() == 30);
+}
+
+XIAOHTTP_TEST(StaticAssetStoreExpiry)
+{
+    StaticAssetStore store(100);
+    auto resp = HttpResponse::newHttpResponse();
+    CHECK(store.insert("a", "", resp, 10, 0.05));
+    CHECK(store.find("a") == resp);
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    CHECK(store.find("a") == nullptr);
+
+    CHECK(store.insert("b", "v1", resp, 10, 0));
+    CHECK(store.find("b") == nullptr);
+    CHECK(store.find("b", "v2") == nullptr);
+    CHECK(store.find("b", "v1") == resp);
+    store.erase("b");
+    CHECK(store.find("b") == nullptr);
+    CHECK(store.bytes() == 10);
+}
@@ -0,0 +1,136 @@
+#include "../../src/StaticFilePrecompressor.h"
+#include <xiaoHttp/xiaoHttp_test.h>
+#include <zlib.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace xiaoHttp;
+namespace fs = std::filesystem;
+
+static std::string readFile(const fs::path &path)
+{
+    std::ifstream infile(path, std::ifstream::binary);
+    std::stringstream ss;
+    ss << infile.rdbuf();
+    return ss.str();
+}
+
+static std::string gunzipFile(const fs::path &path)
+{
+    auto data = readFile(path);
+    z_stream strm{};
+    std::string out;
+    if (inflateInit2(&strm, MAX_WBITS + 16) != Z_OK)
+        return out;
+    strm.next_in = reinterpret_cast<Bytef *>(data.data());
+    strm.avail_in = static_cast<uInt>(data.size());
+    char buf[4096];
+    int ret;
+    do
+    {
+        strm.next_out = reinterpret_cast<Bytef *>(buf);
+        strm.avail_out = sizeof(buf);
+        ret = inflate(&strm, Z_NO_FLUSH);
+        out.append(buf, sizeof(buf) - strm.avail_out);
+    } while (ret == Z_OK);
+    inflateEnd(&strm);
+    return ret == Z_STREAM_END ? out : std::string();
+}
+
+// Poll until the worker is done with the file, or give up after 5 seconds
+static std::string waitForTarget(StaticFilePrecompressor &precompressor,
+                                 const std::string &path,
+                                 size_t fileSize,
+                                 time_t modifiedTime)
+{
+    for (int i = 0; i < 500; ++i)
+    {
+        auto target = precompressor.find(path,
+                                         fileSize,
+                                         modifiedTime,
+                                         ContentCoding::kGzip);
+        if (!target.empty())
+            return target;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return {};
+}
+
+XIAOHTTP_TEST(StaticFilePrecompressorWorker)
+{
+    auto dir = fs::temp_directory_path() /
+               ("xiaohttp_precompress_" +
+                std::to_string(std::chrono::steady_clock::now()
+                                   .time_since_epoch()
+                                   .count()));
+    fs::create_directories(dir);
+    auto source = (dir / "app.js").string();
+    std::string content;
+    for (int i = 0; i < 20000; ++i)
+        content += "var x" + std::to_string(i) + " = " + std::to_string(i) +
+                   ";\n";
+    std::ofstream(source, std::ofstream::binary) << content;
+    auto cacheDir = (dir / "cache").string();
+    {
+        StaticFilePrecompressor precompressor(cacheDir, 16);
+        REQUIRE(precompressor.start());
+
+        // A file that can't be read fails, and stays failed
+        auto missing = (dir / "missing.js").string();
+        CHECK(precompressor
+                  .find(missing, 10, 1000, ContentCoding::kGzip)
+                  .empty());
+
+        // The first request only queues the job
+        CHECK(precompressor
+                  .find(source, content.size(), 1000, ContentCoding::kGzip)
+                  .empty());
+        auto target =
+            waitForTarget(precompressor, source, content.size(), 1000);
+        REQUIRE(!target.empty());
+        CHECK(fs::path(target).parent_path() == fs::path(cacheDir));
+        CHECK(fs::path(target).filename().string().rfind("app.js-", 0) == 0);
+        CHECK(fs::path(target).extension() == ".gz");
+        CHECK(gunzipFile(target) == content);
+
+        // The jobs run in order, so the missing file is done by now
+        CHECK(precompressor
+                  .find(missing, 10, 1000, ContentCoding::kGzip)
+                  .empty());
+
+        // Another modification time is another version of the file
+        CHECK(precompressor
+                  .find(source, content.size(), 2000, ContentCoding::kGzip)
+                  .empty());
+        auto newTarget =
+            waitForTarget(precompressor, source, content.size(), 2000);
+        REQUIRE(!newTarget.empty());
+        CHECK(newTarget != target);
+        CHECK(gunzipFile(newTarget) == content);
+
+        // Only the renamed results are left in the cache directory
+        size_t files = 0;
+        for (auto &entry : fs::directory_iterator(cacheDir))
+        {
+            CHECK(entry.path().extension() != ".tmp");
+            ++files;
+        }
+        CHECK(files == 2);
+    }
+
+    // A new precompressor finds the file of the previous run
+    {
+        StaticFilePrecompressor precompressor(cacheDir, 16);
+        REQUIRE(precompressor.start());
+        auto target =
+            waitForTarget(precompressor, source, content.size(), 1000);
+        CHECK(!target.empty());
+        CHECK(gunzipFile(target) == content);
+    }
+    std::error_code err;
+    fs::remove_all(dir, err);
+}